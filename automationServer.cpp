@@ -0,0 +1,180 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "automationServer.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QJsonDocument>
+
+#include "commandProtocol.h"
+#include "metrics.h"
+
+namespace {
+/// longer requests are not from this protocol, connection is closed
+const int maxRequestSize = 256;
+
+/// running gamepad answers at once, it is local socket
+const int probeTimeoutMs = 100;
+}
+
+AutomationServer::AutomationServer(QObject *parent)
+	: QObject(parent)
+	, mServer(new QLocalServer(this))
+{
+	connect(mServer, SIGNAL(newConnection()), this, SLOT(acceptConnections()));
+}
+
+bool AutomationServer::listen(const QString &path)
+{
+	// socket of a crashed gamepad may be left in file system, it does not answer unlike the one of a running gamepad
+	QLocalSocket probe;
+	probe.connectToServer(path);
+	if (probe.waitForConnected(probeTimeoutMs)) {
+		mError = tr("Another program listens on %1").arg(path);
+		return false;
+	}
+
+	QLocalServer::removeServer(path);
+	mServer->setSocketOptions(QLocalServer::UserAccessOption);
+	if (!mServer->listen(path)) {
+		mError = mServer->errorString();
+		return false;
+	}
+
+	return true;
+}
+
+void AutomationServer::close()
+{
+	mServer->close();
+}
+
+QString AutomationServer::errorString() const
+{
+	return mError;
+}
+
+bool AutomationServer::hasClients() const
+{
+	return !mBuffers.isEmpty();
+}
+
+void AutomationServer::setStatusProvider(const StatusProvider &provider)
+{
+	mStatusProvider = provider;
+}
+
+void AutomationServer::acceptConnections()
+{
+	while (mServer->hasPendingConnections()) {
+		QLocalSocket *connection = mServer->nextPendingConnection();
+		mBuffers.insert(connection, QByteArray());
+		connect(connection, SIGNAL(readyRead()), this, SLOT(readRequests()));
+		connect(connection, &QLocalSocket::disconnected, this, [this, connection]() { releasePads(connection); });
+		connect(connection, SIGNAL(disconnected()), connection, SLOT(deleteLater()));
+		connect(connection, &QObject::destroyed, this, [this, connection]() {
+			mBuffers.remove(connection);
+			mHeldPads.remove(connection);
+		});
+	}
+}
+
+void AutomationServer::readRequests()
+{
+	QLocalSocket *connection = qobject_cast<QLocalSocket *>(sender());
+	if (!connection || !mBuffers.contains(connection)) {
+		return;
+	}
+
+	QByteArray &buffer = mBuffers[connection];
+	buffer += connection->readAll();
+
+	// replies to all requests that came together are written at once
+	QByteArray replies;
+	int start = 0;
+	for (int end = buffer.indexOf('\n'); end != -1; end = buffer.indexOf('\n', start)) {
+		replies += execute(connection, buffer.mid(start, end - start).trimmed());
+		replies += '\n';
+		start = end + 1;
+	}
+
+	buffer.remove(0, start);
+	if (buffer.size() > maxRequestSize) {
+		replies += "error request is too long\n";
+		buffer.clear();
+		connection->write(replies);
+		connection->disconnectFromServer();
+		return;
+	}
+
+	if (!replies.isEmpty()) {
+		connection->write(replies);
+		// client usually waits for the reply, so it is not left until the next event loop iteration
+		connection->flush();
+	}
+}
+
+void AutomationServer::releasePads(QLocalSocket *connection)
+{
+	for (const int id : mHeldPads.take(connection)) {
+		GamepadCommand release;
+		release.type = GamepadCommand::Type::padUp;
+		release.id = id;
+		emit commandPrepared(QString::fromLatin1(release.toLine()));
+	}
+}
+
+QByteArray AutomationServer::execute(QLocalSocket *connection, const QByteArray &request)
+{
+	if (request == "ping") {
+		return "pong";
+	}
+
+	if (request == "status") {
+		QJsonObject status = mStatusProvider ? mStatusProvider() : QJsonObject();
+		QJsonObject commands;
+		commands.insert("queued", static_cast<double>(Metrics::value(Metrics::queuedCommands)));
+		commands.insert("bytesSent", static_cast<double>(Metrics::value(Metrics::bytesSent)));
+		commands.insert("writeFailures", static_cast<double>(Metrics::value(Metrics::writeFailures)));
+		commands.insert("deadManReleases", static_cast<double>(Metrics::value(Metrics::deadManReleases)));
+		status.insert("commands", commands);
+
+		QJsonObject video;
+		video.insert("receivedFps", Metrics::value(Metrics::receivedFps));
+		video.insert("presentedFps", Metrics::value(Metrics::presentedFps));
+		video.insert("decodeMs", Metrics::value(Metrics::decodeMs));
+		video.insert("droppedFrames", static_cast<double>(Metrics::value(Metrics::droppedFrames)));
+		video.insert("reconnects", static_cast<double>(Metrics::value(Metrics::videoReconnects)));
+		status.insert("video", video);
+		return QJsonDocument(status).toJson(QJsonDocument::Compact);
+	}
+
+	const GamepadCommand command = GamepadCommand::parse(request);
+	if (!command.isValid()) {
+		return "error unknown request: " + request.left(maxRequestSize);
+	}
+
+	if (command.type == GamepadCommand::Type::pad) {
+		mHeldPads[connection].insert(command.id);
+	} else if (command.type == GamepadCommand::Type::padUp) {
+		mHeldPads[connection].remove(command.id);
+	}
+
+	emit commandPrepared(QString::fromLatin1(command.toLine()));
+	return "ok";
+}
@@ -0,0 +1,88 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QSet>
+
+#include <functional>
+
+class QLocalServer;
+class QLocalSocket;
+
+/// Lets other programs drive gamepad through a local socket, without faking key presses in its window.
+/// Protocol is text, one request per line, and every request gets exactly one reply line, so requests can be
+/// pipelined:
+///   pad <id> <x> <y>, pad <id> up, btn <id>, wheel <percent> -- commands of gamepad protocol, reply is "ok"
+///   status -- reply is JSON object in one line with connection and video statistics
+///   ping -- reply is "pong", it shows overhead of the socket itself
+/// Wrong requests are replied with "error <description>". Commands are passed on by commandPrepared() signal,
+/// the same way as commands of strategies, so they are mixed with the ones from keyboard. Pads that a client
+/// holds are released when it disconnects, so a crashed client does not leave robot driving.
+class AutomationServer : public QObject
+{
+	Q_OBJECT
+
+private:
+	AutomationServer(const AutomationServer &other);
+	AutomationServer & operator=(const AutomationServer &other);
+
+public:
+	typedef std::function<QJsonObject()> StatusProvider;
+
+	explicit AutomationServer(QObject *parent = nullptr);
+
+	/// path of Unix socket or name of Windows pipe, a socket left by crashed gamepad is removed, but the one
+	/// of running gamepad is not. Socket is accessible by the current user only
+	bool listen(const QString &path);
+	void close();
+
+	QString errorString() const;
+
+	/// returns true while some program is connected, its commands do not depend on focus of gamepad window
+	bool hasClients() const;
+
+	/// provider adds state of connection to status, counters of commands and video are taken from Metrics
+	void setStatusProvider(const StatusProvider &provider);
+
+signals:
+	void commandPrepared(const QString &command);
+
+private slots:
+	void acceptConnections();
+	void readRequests();
+
+private:
+	/// sends release of pads that given connection holds
+	void releasePads(QLocalSocket *connection);
+	QByteArray execute(QLocalSocket *connection, const QByteArray &request);
+
+	QLocalServer *mServer;
+
+	/// requests that are not completely received yet
+	QHash<QLocalSocket *, QByteArray> mBuffers;
+
+	/// ids of pads that are held by each connection
+	QHash<QLocalSocket *, QSet<int>> mHeldPads;
+
+	QString mError;
+
+	StatusProvider mStatusProvider;
+};
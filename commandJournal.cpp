@@ -0,0 +1,145 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "commandJournal.h"
+
+#include <QDateTime>
+#include <QMutexLocker>
+
+#include <chrono>
+#include <cstring>
+
+using namespace commandJournal;
+
+CommandJournal::CommandJournal(QObject *parent)
+	: QThread(parent)
+	, mIsClosing(false)
+{
+	setObjectName("journal");
+}
+
+CommandJournal::~CommandJournal()
+{
+	close();
+}
+
+bool CommandJournal::open(const QString &fileName)
+{
+	close();
+	mFile.setFileName(fileName);
+	if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		mErrorString = mFile.errorString();
+		return false;
+	}
+
+	JournalHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = magic;
+	header.version = version;
+	header.headerSize = sizeof(JournalHeader);
+	header.recordSize = sizeof(JournalRecord);
+	header.startWallClockMs = QDateTime::currentMSecsSinceEpoch();
+	header.startTimestampNs = timestamp();
+	const qint64 headerSize = static_cast<qint64>(sizeof(header));
+	if (mFile.write(reinterpret_cast<const char *>(&header), headerSize) != headerSize) {
+		mErrorString = mFile.errorString();
+		mFile.close();
+		return false;
+	}
+
+	mFile.flush();
+	mIsClosing = false;
+	start(QThread::LowPriority);
+	return true;
+}
+
+void CommandJournal::close()
+{
+	if (!isRunning()) {
+		return;
+	}
+
+	{
+		QMutexLocker locker(&mMutex);
+		mIsClosing = true;
+		mHasRecords.wakeOne();
+	}
+
+	wait();
+	mFile.close();
+}
+
+bool CommandJournal::isOpen() const
+{
+	return isRunning();
+}
+
+QString CommandJournal::errorString() const
+{
+	return mErrorString;
+}
+
+void CommandJournal::append(const QByteArray &command, qint64 timestampNs)
+{
+	JournalRecord record;
+	memset(&record, 0, sizeof(record));
+	record.timestampNs = timestampNs;
+	record.isTruncated = command.size() > static_cast<int>(maxCommandSize) ? 1 : 0;
+	record.size = static_cast<uint8_t>(qMin(command.size(), static_cast<int>(maxCommandSize)));
+	memcpy(record.command, command.constData(), record.size);
+
+	QMutexLocker locker(&mMutex);
+	mPendingRecords.push_back(record);
+	if (mPendingRecords.size() == 1) {
+		mHasRecords.wakeOne();
+	}
+}
+
+qint64 CommandJournal::timestamp()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void CommandJournal::run()
+{
+	std::vector<JournalRecord> records;
+	bool isClosing = false;
+	while (!isClosing) {
+		{
+			QMutexLocker locker(&mMutex);
+			while (mPendingRecords.empty() && !mIsClosing) {
+				mHasRecords.wait(&mMutex);
+			}
+
+			records.swap(mPendingRecords);
+			isClosing = mIsClosing;
+		}
+
+		if (records.empty()) {
+			continue;
+		}
+
+		const qint64 size = static_cast<qint64>(records.size() * sizeof(JournalRecord));
+		// every batch is flushed, so journal of a crashed gamepad has everything up to the crash
+		if (mFile.write(reinterpret_cast<const char *>(records.data()), size) != size || !mFile.flush()) {
+			mErrorString = mFile.errorString();
+		}
+
+		records.clear();
+	}
+}
@@ -0,0 +1,70 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QThread>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <vector>
+
+#include "commandJournalFormat.h"
+
+/// Writes every command sent to robot to a binary journal (see commandJournalFormat.h), so an incident can be
+/// replayed later with original timing by journalReplay tool. Commands are only copied to memory by append(),
+/// file is written by own thread of journal, so connection thread is never blocked by disk.
+class CommandJournal : public QThread
+{
+	Q_OBJECT
+
+private:
+	CommandJournal(const CommandJournal &other);
+	CommandJournal & operator=(const CommandJournal &other);
+
+public:
+	explicit CommandJournal(QObject *parent = nullptr);
+	~CommandJournal() override;
+
+	/// creates journal file and starts writing thread
+	bool open(const QString &fileName);
+
+	/// writes all appended commands and stops writing thread
+	void close();
+
+	bool isOpen() const;
+	QString errorString() const;
+
+	/// can be called from any thread
+	void append(const QByteArray &command, qint64 timestampNs);
+
+	/// steady clock in nanoseconds, the one timestamps of records are taken from
+	static qint64 timestamp();
+
+protected:
+	void run() override;
+
+private:
+	QFile mFile;
+	QString mErrorString;
+
+	QMutex mMutex;
+	QWaitCondition mHasRecords;
+	std::vector<commandJournal::JournalRecord> mPendingRecords;
+	bool mIsClosing;
+};
@@ -0,0 +1,68 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+/// Layout of command journal file, see CommandJournal. This header does not depend on Qt,
+/// so journal can be read by other programs as is.
+///
+/// File is JournalHeader followed by JournalRecord for every command passed to ConnectionManager::write(),
+/// all numbers are little-endian. File that was not closed properly is still valid up to the last whole record.
+
+#include <stdint.h>
+
+namespace commandJournal {
+
+/// 'TRKJ'
+const uint32_t magic = 0x4a4b5254;
+const uint32_t version = 1;
+
+/// commands of gamepad protocol are much shorter, longer ones are truncated
+const uint32_t maxCommandSize = 22;
+
+struct JournalHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t recordSize;
+
+	/// wall clock time in milliseconds since epoch and steady clock time in nanoseconds at the moment journal was
+	/// opened, they relate timestamps of records to real time of the incident
+	int64_t startWallClockMs;
+	int64_t startTimestampNs;
+};
+
+struct JournalRecord
+{
+	/// steady clock time (CLOCK_MONOTONIC on Linux) of the moment command was passed to socket, in nanoseconds
+	int64_t timestampNs;
+
+	/// size of command in bytes, including '\n'
+	uint8_t size;
+
+	/// 1 if command was longer than maxCommandSize and is truncated
+	uint8_t isTruncated;
+
+	/// command as it was sent, not null-terminated
+	char command[maxCommandSize];
+};
+
+static_assert(sizeof(JournalHeader) == 32, "Journal header shall be 32 bytes long");
+static_assert(sizeof(JournalRecord) == 32, "Journal record shall be 32 bytes long");
+
+}
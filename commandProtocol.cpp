@@ -0,0 +1,85 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "commandProtocol.h"
+
+#include <QList>
+
+namespace {
+const int padsCount = 2;
+const int buttonsCount = 5;
+const int maxValue = 100;
+
+bool toValue(const QByteArray &word, int min, int max, int &value)
+{
+	bool ok = false;
+	value = word.toInt(&ok);
+	return ok && value >= min && value <= max;
+}
+}
+
+bool GamepadCommand::isValid() const
+{
+	return type != Type::invalid;
+}
+
+GamepadCommand GamepadCommand::parse(const QByteArray &line)
+{
+	GamepadCommand command;
+	const QList<QByteArray> words = line.simplified().split(' ');
+	const QByteArray &name = words.first();
+
+	if (name == "pad" && words.size() == 3 && words.at(2) == "up") {
+		if (toValue(words.at(1), 1, padsCount, command.id)) {
+			command.type = Type::padUp;
+		}
+	} else if (name == "pad" && words.size() == 4) {
+		if (toValue(words.at(1), 1, padsCount, command.id)
+				&& toValue(words.at(2), -maxValue, maxValue, command.x)
+				&& toValue(words.at(3), -maxValue, maxValue, command.y)) {
+			command.type = Type::pad;
+		}
+	} else if (name == "btn" && words.size() == 2) {
+		if (toValue(words.at(1), 1, buttonsCount, command.id)) {
+			command.type = Type::button;
+		}
+	} else if (name == "wheel" && words.size() == 2) {
+		if (toValue(words.at(1), -maxValue, maxValue, command.x)) {
+			command.type = Type::wheel;
+		}
+	}
+
+	return command;
+}
+
+QByteArray GamepadCommand::toLine() const
+{
+	switch (type) {
+	case Type::pad:
+		return "pad " + QByteArray::number(id) + ' ' + QByteArray::number(x) + ' ' + QByteArray::number(y) + '\n';
+	case Type::padUp:
+		return "pad " + QByteArray::number(id) + " up\n";
+	case Type::button:
+		return "btn " + QByteArray::number(id) + '\n';
+	case Type::wheel:
+		return "wheel " + QByteArray::number(x) + '\n';
+	case Type::invalid:
+		break;
+	}
+
+	return QByteArray();
+}
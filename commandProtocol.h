@@ -0,0 +1,51 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QByteArray>
+
+/// One command of gamepad protocol, see README.md for the grammar:
+///   pad <id> <x> <y>, pad <id> up, btn <id>, wheel <percent>
+/// Commands are separated by '\n', extra spaces are allowed.
+struct GamepadCommand
+{
+	enum class Type {
+		invalid
+		, pad
+		, padUp
+		, button
+		, wheel
+	};
+
+	Type type = Type::invalid;
+
+	/// pad or button id, not used by wheel
+	int id = 0;
+
+	/// coordinates of pad, wheel keeps its percent in x
+	int x = 0;
+	int y = 0;
+
+	bool isValid() const;
+
+	/// parses one line without trailing '\n', returns invalid command if line does not follow the grammar
+	static GamepadCommand parse(const QByteArray &line);
+
+	/// line in the form that gamepad sends, with trailing '\n'
+	QByteArray toLine() const;
+};
@@ -0,0 +1,206 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "commandScheduler.h"
+
+#include "commandProtocol.h"
+#include "metrics.h"
+#include "tracer.h"
+
+#include <QMutexLocker>
+
+#include <chrono>
+
+namespace {
+const Metrics::Counter takenCounters[] = {Metrics::urgentScheduledCommands, Metrics::continuousScheduledCommands};
+const Metrics::Counter waitCounters[] = {Metrics::urgentWaitNs, Metrics::continuousWaitNs};
+const Metrics::Gauge depthGauges[] = {Metrics::urgentQueueDepth, Metrics::continuousQueueDepth};
+}
+
+CommandScheduler::CommandScheduler()
+	: mNextOrder(0)
+	, mIsWakeUpPending(false)
+{
+	for (int i = 0; i < prioritiesCount; ++i) {
+		mMaxQueueDepth[i] = 0;
+		mTaken[i] = 0;
+		mReplaced[i] = 0;
+		mWaitNs[i] = 0;
+		mMaxWaitNs[i] = 0;
+	}
+}
+
+bool CommandScheduler::push(const QByteArray &command, const GamepadCommand &parsed, quint64 traceId)
+{
+	Command entry;
+	entry.data = command;
+	entry.enqueuedNs = timestamp();
+	entry.traceId = traceId;
+
+	QMutexLocker locker(&mMutex);
+	if (parsed.type == GamepadCommand::Type::pad || parsed.type == GamepadCommand::Type::wheel) {
+		const Slot slot = parsed.type == GamepadCommand::Type::wheel ? wheel : static_cast<Slot>(parsed.id - 1);
+		ContinuousCommand &waiting = mContinuous[slot];
+		if (waiting.isWaiting) {
+			dropContinuous(slot);
+		} else {
+			waiting.order = mNextOrder++;
+		}
+
+		waiting.command = entry;
+		waiting.isWaiting = true;
+		updateDepth(continuous, continuousDepth());
+	} else {
+		if (parsed.type == GamepadCommand::Type::padUp) {
+			// robot should stop, so position that was not written yet is of no use
+			dropContinuous(static_cast<Slot>(parsed.id - 1));
+			updateDepth(continuous, continuousDepth());
+		}
+
+		mUrgent.enqueue(entry);
+		updateDepth(urgent, mUrgent.size());
+	}
+
+	const bool isWakeUpNeeded = !mIsWakeUpPending;
+	mIsWakeUpPending = true;
+	return isWakeUpNeeded;
+}
+
+void CommandScheduler::beginTaking()
+{
+	QMutexLocker locker(&mMutex);
+	mIsWakeUpPending = false;
+}
+
+bool CommandScheduler::take(bool isContinuousAllowed, Command &command)
+{
+	QMutexLocker locker(&mMutex);
+	Priority priority = urgent;
+	if (!mUrgent.isEmpty()) {
+		command = mUrgent.dequeue();
+		updateDepth(urgent, mUrgent.size());
+	} else {
+		if (!isContinuousAllowed) {
+			return false;
+		}
+
+		int oldest = -1;
+		for (int i = 0; i < slotsCount; ++i) {
+			if (mContinuous[i].isWaiting && (oldest == -1 || mContinuous[i].order < mContinuous[oldest].order)) {
+				oldest = i;
+			}
+		}
+
+		if (oldest == -1) {
+			return false;
+		}
+
+		priority = continuous;
+		command = mContinuous[oldest].command;
+		mContinuous[oldest].isWaiting = false;
+		updateDepth(continuous, continuousDepth());
+	}
+
+	const qint64 waitNs = timestamp() - command.enqueuedNs;
+	++mTaken[priority];
+	mWaitNs[priority] += waitNs;
+	mMaxWaitNs[priority] = qMax(mMaxWaitNs[priority], waitNs);
+	Metrics::add(takenCounters[priority]);
+	Metrics::add(waitCounters[priority], static_cast<quint64>(waitNs));
+	return true;
+}
+
+void CommandScheduler::clear()
+{
+	QMutexLocker locker(&mMutex);
+	for (const Command &command : mUrgent) {
+		if (command.traceId != 0) {
+			Tracer::asyncEnd("queued hop", command.traceId);
+		}
+	}
+
+	mUrgent.clear();
+	for (int i = 0; i < slotsCount; ++i) {
+		if (mContinuous[i].isWaiting && mContinuous[i].command.traceId != 0) {
+			Tracer::asyncEnd("queued hop", mContinuous[i].command.traceId);
+		}
+
+		mContinuous[i].isWaiting = false;
+	}
+
+	updateDepth(urgent, 0);
+	updateDepth(continuous, 0);
+}
+
+void CommandScheduler::takeStatistics(Statistics statistics[prioritiesCount])
+{
+	QMutexLocker locker(&mMutex);
+	for (int i = 0; i < prioritiesCount; ++i) {
+		Statistics &result = statistics[i];
+		result.queueDepth = i == urgent ? mUrgent.size() : continuousDepth();
+		result.maxQueueDepth = mMaxQueueDepth[i];
+		result.taken = mTaken[i];
+		result.replaced = mReplaced[i];
+		result.averageWaitMs = mTaken[i] > 0 ? mWaitNs[i] / 1e6 / mTaken[i] : 0;
+		result.maxWaitMs = mMaxWaitNs[i] / 1e6;
+
+		mMaxQueueDepth[i] = result.queueDepth;
+		mTaken[i] = 0;
+		mReplaced[i] = 0;
+		mWaitNs[i] = 0;
+		mMaxWaitNs[i] = 0;
+	}
+}
+
+qint64 CommandScheduler::timestamp()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void CommandScheduler::dropContinuous(Slot slot)
+{
+	ContinuousCommand &waiting = mContinuous[slot];
+	if (!waiting.isWaiting) {
+		return;
+	}
+
+	waiting.isWaiting = false;
+	++mReplaced[continuous];
+	Metrics::add(Metrics::replacedCommands);
+	if (waiting.command.traceId != 0) {
+		Tracer::asyncEnd("queued hop", waiting.command.traceId);
+	}
+}
+
+int CommandScheduler::continuousDepth() const
+{
+	int depth = 0;
+	for (int i = 0; i < slotsCount; ++i) {
+		if (mContinuous[i].isWaiting) {
+			++depth;
+		}
+	}
+
+	return depth;
+}
+
+void CommandScheduler::updateDepth(Priority priority, int depth)
+{
+	mMaxQueueDepth[priority] = qMax(mMaxQueueDepth[priority], depth);
+	Metrics::set(depthGauges[priority], depth);
+}
@@ -0,0 +1,115 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QQueue>
+
+struct GamepadCommand;
+
+/// Orders commands that wait to be written by connection thread. Releases of pads, buttons and unknown commands
+/// are urgent, they are written first in order of arrival. Positions of pads and wheel are continuous: only
+/// the latest position of each of them waits, so under heavy traffic newer positions replace older ones instead of
+/// queueing up. Release of a pad drops its waiting position, so robot never gets a stale position after release.
+/// All methods are thread-safe.
+class CommandScheduler
+{
+public:
+	enum Priority {
+		urgent = 0
+		, continuous
+		, prioritiesCount
+	};
+
+	struct Command
+	{
+		QByteArray data;
+		qint64 enqueuedNs = 0;
+
+		/// id of "queued hop" span in trace, 0 if tracing is off
+		quint64 traceId = 0;
+	};
+
+	/// statistics of one priority since previous CommandScheduler::takeStatistics() call,
+	/// totals for Prometheus are kept by Metrics
+	struct Statistics
+	{
+		int queueDepth = 0;
+		int maxQueueDepth = 0;
+		quint64 taken = 0;
+		quint64 replaced = 0;
+		double averageWaitMs = 0;
+		double maxWaitMs = 0;
+	};
+
+	CommandScheduler();
+
+	/// parsed is the command parsed by GamepadCommand::parse(),
+	/// returns true if connection thread should be woken up to take commands
+	bool push(const QByteArray &command, const GamepadCommand &parsed, quint64 traceId);
+
+	/// is called by connection thread before taking commands, commands pushed after it wake the thread again
+	void beginTaking();
+
+	/// takes the most urgent command, continuous ones are taken only if isContinuousAllowed
+	bool take(bool isContinuousAllowed, Command &command);
+
+	/// drops all waiting commands
+	void clear();
+
+	void takeStatistics(Statistics statistics[prioritiesCount]);
+
+	/// steady clock in nanoseconds
+	static qint64 timestamp();
+
+private:
+	/// continuous commands that can wait at the same time
+	enum Slot {
+		pad1 = 0
+		, pad2
+		, wheel
+		, slotsCount
+	};
+
+	struct ContinuousCommand
+	{
+		Command command;
+		bool isWaiting = false;
+
+		/// continuous commands are taken in order of arrival, replacing keeps place of replaced command
+		quint64 order = 0;
+	};
+
+	/// removes waiting command from the slot, counting it as replaced
+	void dropContinuous(Slot slot);
+	int continuousDepth() const;
+	void updateDepth(Priority priority, int depth);
+
+	QMutex mMutex;
+	QQueue<Command> mUrgent;
+	ContinuousCommand mContinuous[slotsCount];
+	quint64 mNextOrder;
+	bool mIsWakeUpPending;
+
+	int mMaxQueueDepth[prioritiesCount];
+	quint64 mTaken[prioritiesCount];
+	quint64 mReplaced[prioritiesCount];
+	qint64 mWaitNs[prioritiesCount];
+	qint64 mMaxWaitNs[prioritiesCount];
+};
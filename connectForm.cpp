@@ -20,6 +20,7 @@
 
 
 #include <QtWidgets/QMessageBox>
+#include <QtCore/QSettings>
 
 
 ConnectForm::ConnectForm(ConnectionManager *manager
@@ -46,6 +47,27 @@ ConnectForm::ConnectForm(ConnectionManager *manager
 	connect(mUi->connectButton, &QPushButton::pressed, this, &ConnectForm::onConnectButtonClicked);
 	connect(mUi->advancedButton, &QPushButton::pressed, this, &ConnectForm::onAdvancedButtonClicked);
 	connect(mUi->robotIpLineEdit, &QLineEdit::textEdited, this, &ConnectForm::copyGamepadIpToCameraIp);
+
+	mUi->scanButton->setText(tr("Find robots"));
+	mUi->robotsListWidget->setVisible(false);
+	connect(mUi->scanButton, &QPushButton::pressed, this, &ConnectForm::onScanButtonClicked);
+	connect(mUi->robotsListWidget, &QListWidget::itemClicked, this, &ConnectForm::chooseRobot);
+	connect(mUi->robotsListWidget, &QListWidget::itemDoubleClicked, this, [this](QListWidgetItem *item) {
+		if (!item->data(Qt::UserRole).isNull()) {
+			chooseRobot(item);
+			onConnectButtonClicked();
+		}
+	});
+	connect(&mScanner, &RobotScanner::portFound, this, &ConnectForm::addFoundPort);
+	connect(&mScanner, &RobotScanner::hostNameFound, this, &ConnectForm::addHostName);
+	connect(&mScanner, &RobotScanner::finished, this, &ConnectForm::handleScanFinished);
+
+	connect(&mPreConnector, &PreConnector::gamepadReachabilityChanged, this, &ConnectForm::showGamepadReachability);
+	connect(&mPreConnector, &PreConnector::cameraReachabilityChanged, this, &ConnectForm::showCameraReachability);
+	for (QLineEdit *edit : {mUi->robotIpLineEdit, mUi->robotPortLineEdit, mUi->cameraIPLineEdit
+			, mUi->cameraPortLineEdit}) {
+		connect(edit, &QLineEdit::textChanged, this, &ConnectForm::updatePreConnection);
+	}
 }
 
 ConnectForm::ConnectForm(ConnectionManager *manager, const QMap<QString, QString> &args, QWidget *parent)
@@ -56,6 +78,7 @@ ConnectForm::ConnectForm(ConnectionManager *manager, const QMap<QString, QString
 	mUi->robotPortLineEdit->setText(args.value("gamepadPort", "4444"));
 	mUi->cameraIPLineEdit->setText(args.value("cameraIp", "192.168.77.1"));
 	mUi->cameraPortLineEdit->setText(args.value("cameraPort", "8080"));
+	updatePreConnection();
 }
 
 ConnectForm::~ConnectForm()
@@ -68,6 +91,11 @@ void ConnectForm::onConnectButtonClicked()
 	const auto ip = mUi->robotIpLineEdit->text();
 	const quint16 port = static_cast<quint16>(mUi->robotPortLineEdit->text().toInt());
 
+	QTcpSocket *connectedSocket = mPreConnector.takeGamepadSocket(ip, port);
+	if (connectedSocket) {
+		connectionManager->adoptSocket(connectedSocket);
+	}
+
 	if (mUi->cameraIPLineEdit->text().isEmpty())
 		connectionManager->setCameraIp(ip);
 	else
@@ -94,6 +122,158 @@ void ConnectForm::copyGamepadIpToCameraIp(const QString& text)
 	mUi->cameraIPLineEdit->setText(text);
 }
 
+void ConnectForm::onScanButtonClicked()
+{
+	const QStringList subnets = QSettings().value("connection/scanSubnets", QStringList{"192.168.77.0/24"})
+			.toStringList();
+	const quint16 gamepadPort = static_cast<quint16>(mUi->robotPortLineEdit->text().toInt());
+	const quint16 cameraPort = static_cast<quint16>(mUi->cameraPortLineEdit->text().toInt());
+
+	mFoundRobots.clear();
+	mUi->robotsListWidget->clear();
+	mScanGamepadPort = gamepadPort;
+	mScanCameraPort = cameraPort;
+	if (!mScanner.start(subnets, gamepadPort, cameraPort)) {
+		QMessageBox::warning(this, tr("Find robots"), tr("No valid subnets to scan: %1").arg(subnets.join(", ")));
+		return;
+	}
+
+	mUi->robotsListWidget->setVisible(true);
+	mUi->scanButton->setEnabled(false);
+	mUi->scanButton->setText(tr("Searching..."));
+}
+
+void ConnectForm::addFoundPort(const QHostAddress &address, quint16 port)
+{
+	// ports are the ones of the scan, fields can be edited while it runs, and one port can have both roles
+	FoundRobot &robot = foundRobot(address);
+	if (port == mScanGamepadPort) {
+		robot.isGamepadOpen = true;
+	}
+
+	if (port == mScanCameraPort) {
+		robot.isCameraOpen = true;
+	}
+
+	updateFoundRobot(address);
+}
+
+void ConnectForm::addHostName(const QHostAddress &address, const QString &name)
+{
+	foundRobot(address).name = name;
+	updateFoundRobot(address);
+}
+
+void ConnectForm::handleScanFinished(int hosts, qint64 elapsedMs)
+{
+	mUi->scanButton->setEnabled(true);
+	mUi->scanButton->setText(tr("Find robots"));
+	if (mFoundRobots.isEmpty()) {
+		new QListWidgetItem(tr("No robots among %1 hosts (%2 ms)").arg(hosts).arg(elapsedMs), mUi->robotsListWidget);
+	}
+}
+
+void ConnectForm::chooseRobot(QListWidgetItem *item)
+{
+	const QString address = item->data(Qt::UserRole).toString();
+	if (address.isEmpty()) {
+		return;
+	}
+
+	mUi->robotIpLineEdit->setText(address);
+	mUi->cameraIPLineEdit->setText(address);
+}
+
+ConnectForm::FoundRobot &ConnectForm::foundRobot(const QHostAddress &address)
+{
+	const quint32 key = address.toIPv4Address();
+	if (!mFoundRobots.contains(key)) {
+		QListWidgetItem *item = new QListWidgetItem(mUi->robotsListWidget);
+		item->setData(Qt::UserRole, address.toString());
+		mFoundRobots.insert(key, {item, QString(), false, false});
+	}
+
+	return mFoundRobots[key];
+}
+
+void ConnectForm::updateFoundRobot(const QHostAddress &address)
+{
+	const FoundRobot &robot = foundRobot(address);
+	QString text = address.toString();
+	if (!robot.name.isEmpty()) {
+		text += " (" + robot.name + ")";
+	}
+
+	QStringList ports;
+	if (robot.isGamepadOpen) {
+		ports << tr("gamepad");
+	}
+
+	if (robot.isCameraOpen) {
+		ports << tr("camera");
+	}
+
+	robot.item->setText(text + ": " + ports.join(", "));
+}
+
+void ConnectForm::updatePreConnection()
+{
+	mPreConnector.setTarget(mUi->robotIpLineEdit->text()
+			, static_cast<quint16>(mUi->robotPortLineEdit->text().toInt())
+			, cameraIp()
+			, static_cast<quint16>(mUi->cameraPortLineEdit->text().toInt()));
+}
+
+QString ConnectForm::cameraIp() const
+{
+	// the same rule as onConnectButtonClicked() follows
+	return mUi->cameraIPLineEdit->text().isEmpty() ? mUi->robotIpLineEdit->text() : mUi->cameraIPLineEdit->text();
+}
+
+void ConnectForm::showGamepadReachability(PreConnector::Reachability reachability, qint64 elapsedMs)
+{
+	mGamepadReachability = reachabilityText(reachability, elapsedMs);
+	updateReachabilityLabel();
+}
+
+void ConnectForm::showCameraReachability(PreConnector::Reachability reachability, qint64 elapsedMs)
+{
+	mCameraReachability = reachabilityText(reachability, elapsedMs);
+	updateReachabilityLabel();
+}
+
+QString ConnectForm::reachabilityText(PreConnector::Reachability reachability, qint64 elapsedMs) const
+{
+	switch (reachability) {
+	case PreConnector::Reachability::resolving:
+		return tr("resolving...");
+	case PreConnector::Reachability::connecting:
+		return tr("connecting...");
+	case PreConnector::Reachability::reachable:
+		return tr("reachable (%1 ms)").arg(elapsedMs);
+	case PreConnector::Reachability::unreachable:
+		return tr("unreachable");
+	case PreConnector::Reachability::unknown:
+		break;
+	}
+
+	return QString();
+}
+
+void ConnectForm::updateReachabilityLabel()
+{
+	QStringList lines;
+	if (!mGamepadReachability.isEmpty()) {
+		lines << tr("Robot: %1").arg(mGamepadReachability);
+	}
+
+	if (!mCameraReachability.isEmpty()) {
+		lines << tr("Camera: %1").arg(mCameraReachability);
+	}
+
+	mUi->reachabilityLabel->setText(lines.join("\n"));
+}
+
 void ConnectForm::setVisibilityToAdditionalButtons(bool mode)
 {
 	mUi->cameraIPLabel->setVisible(mode);
@@ -22,6 +22,10 @@
 
 
 #include "connectionManager.h"
+#include "robotScanner.h"
+#include "preConnector.h"
+
+class QListWidgetItem;
 
 namespace Ui {
 class ConnectForm;
@@ -56,17 +60,54 @@ private slots:
 	/// Slot for copying GamepadIp to CameraIp when Advanced button wasn't pressed
 	void copyGamepadIpToCameraIp(const QString &text);
 
+	/// scans subnets from "connection/scanSubnets" setting for robots, results are added to the list as they come
+	void onScanButtonClicked();
+	void addFoundPort(const QHostAddress &address, quint16 port);
+	void addHostName(const QHostAddress &address, const QString &name);
+	void handleScanFinished(int hosts, qint64 elapsedMs);
+
+	/// puts address of robot chosen in the list into address fields
+	void chooseRobot(QListWidgetItem *item);
+
+	/// starts connecting to address in the fields in advance, so Connect button does not wait for it
+	void updatePreConnection();
+	void showGamepadReachability(PreConnector::Reachability reachability, qint64 elapsedMs);
+	void showCameraReachability(PreConnector::Reachability reachability, qint64 elapsedMs);
+
 signals:
 	/// Signal is emitted when user presses ConnectButton
 	void dataReceived();
 
 private:
+	/// what is known about a host that was found by scanner
+	struct FoundRobot
+	{
+		QListWidgetItem *item;
+		QString name;
+		bool isGamepadOpen;
+		bool isCameraOpen;
+	};
+
 	void setVisibilityToAdditionalButtons(bool mode);
+	FoundRobot &foundRobot(const QHostAddress &address);
+	void updateFoundRobot(const QHostAddress &address);
+	QString cameraIp() const;
+	QString reachabilityText(PreConnector::Reachability reachability, qint64 elapsedMs) const;
+	void updateReachabilityLabel();
 
 	/// Field with GUI automatically generated by connectForm.ui.
 	QScopedPointer<Ui::ConnectForm> mUi;
 
 	/// ConnectionManager for saving state of internet connection
 	ConnectionManager *connectionManager; /// Does not have ownership
+
+	RobotScanner mScanner;
+	QHash<quint32, FoundRobot> mFoundRobots;
+	quint16 mScanGamepadPort = 0;
+	quint16 mScanCameraPort = 0;
+
+	PreConnector mPreConnector;
+	QString mGamepadReachability;
+	QString mCameraReachability;
 };
 
@@ -17,30 +17,93 @@
 
 #include "connectionManager.h"
 
+#include "tracer.h"
+#include "metrics.h"
+#include "commandJournal.h"
+#include "commandProtocol.h"
+
+namespace {
+/// positions of pads and wheel wait in scheduler while socket has more than that to send,
+/// so newer positions replace them there instead of queueing up in socket buffer
+const qint64 maxBytesToWrite = 64;
+
+/// telemetry is passed to GUI in batches, so thousands of lines per second do not flood its event loop
+const int telemetryPublishIntervalMs = 33;
+}
+
 ConnectionManager::ConnectionManager()
 	: socket(new QTcpSocket(this))
 	, cameraIp("192.168.77.1")
 	, cameraPort("8080")
 	, gamepadIp("192.168.77.1")
 	, gamepadPort(4444)
+	, journal(nullptr)
+	, deadManWatchdog(this)
+	, isStreaming(false)
+	// timer is a child, so it moves to connection thread together with manager
+	, streamTimer(this)
+	, isSocketConnected(false)
+	, peakBytesToWrite(0)
+	, resyncStartNs(-1)
+	, resyncCommands(0)
+	, telemetryTimer(this)
 {
 	/// passing this to QTcpSocket forces automatically socket->moveToThread()
 	/// when calling connectionManaget.moveToThread()
 	qRegisterMetaType<QAbstractSocket::SocketState>();
-	connect(socket, SIGNAL(stateChanged(QAbstractSocket::SocketState)),
-			this, SIGNAL(stateChanged(QAbstractSocket::SocketState)));
+	qRegisterMetaType<QTcpSocket *>();
+	qRegisterMetaType<QVector<TelemetrySample>>();
+	connectSocket();
+	connect(&deadManWatchdog, SIGNAL(stalled(qint64)), this, SLOT(releaseHeldPads(qint64)));
+	streamTimer.setTimerType(Qt::PreciseTimer);
+	connect(&streamTimer, SIGNAL(timeout()), this, SLOT(sendStateChanges()));
+	telemetryTimer.setInterval(telemetryPublishIntervalMs);
+	connect(&telemetryTimer, SIGNAL(timeout()), this, SLOT(publishTelemetry()));
 }
 
 ConnectionManager::~ConnectionManager()
 {
-	disconnect(socket, SIGNAL(stateChanged(QAbstractSocket::SocketState)),
-			   this, SIGNAL(stateChanged(QAbstractSocket::SocketState)));
+	socket->disconnect(this);
 	delete socket;
 }
 
+void ConnectionManager::connectSocket()
+{
+	connect(socket, SIGNAL(stateChanged(QAbstractSocket::SocketState)),
+			this, SIGNAL(stateChanged(QAbstractSocket::SocketState)));
+	connect(socket, SIGNAL(stateChanged(QAbstractSocket::SocketState))
+			, this, SLOT(handleStateChanged(QAbstractSocket::SocketState)));
+	connect(socket, SIGNAL(bytesWritten(qint64)), this, SLOT(handleBytesWritten()));
+	connect(socket, SIGNAL(readyRead()), this, SLOT(readTelemetry()));
+}
+
+void ConnectionManager::adoptSocket(QTcpSocket *connectedSocket)
+{
+	connectedSocket->disconnect();
+	connectedSocket->moveToThread(thread());
+	QMetaObject::invokeMethod(this, "replaceSocket", Qt::QueuedConnection, Q_ARG(QTcpSocket *, connectedSocket));
+}
+
+void ConnectionManager::replaceSocket(QTcpSocket *connectedSocket)
+{
+	// previous connection is closed through usual handlers, so state of robot and scheduler are reset
+	socket->abort();
+	socket->disconnect(this);
+	socket->deleteLater();
+
+	socket = connectedSocket;
+	socket->setParent(this);
+	connectSocket();
+	if (socket->state() == QAbstractSocket::ConnectedState) {
+		Metrics::add(Metrics::connectionAttempts);
+		handleStateChanged(QAbstractSocket::ConnectedState);
+		emit stateChanged(QAbstractSocket::ConnectedState);
+	}
+}
+
 bool ConnectionManager::isConnected() const
 {
-	return socket->state() == QTcpSocket::ConnectedState;
+	return isSocketConnected;
 }
 
 QString ConnectionManager::getCameraIp() const
@@ -48,9 +111,270 @@ QString ConnectionManager::getCameraIp() const
 	return cameraIp;
 }
 
+void ConnectionManager::send(const QString &command)
+{
+	const QByteArray data = command.toLatin1();
+	const GamepadCommand parsed = GamepadCommand::parse(data);
+	{
+		QMutexLocker locker(&inputStateMutex);
+		// state is kept while there is no connection too, so it is resent correctly after reconnection
+		const bool isState = inputState.apply(parsed);
+		if (!isSocketConnected) {
+			inputState.buttonPresses.clear();
+			return;
+		}
+
+		Metrics::add(Metrics::queuedCommands);
+		if (isState && isStreaming) {
+			// it is sent by the next tick of streamTimer
+			return;
+		}
+
+		// button presses are sent as commands, not as state
+		inputState.buttonPresses.clear();
+	}
+
+	quint64 traceId = 0;
+	if (Tracer::isEnabled()) {
+		traceId = Tracer::nextCommandId();
+		Tracer::asyncBegin("queued hop", traceId);
+	}
+
+	if (scheduler.push(data, parsed, traceId)) {
+		QMetaObject::invokeMethod(this, "writeScheduled", Qt::QueuedConnection);
+	}
+}
+
+void ConnectionManager::takeSchedulerStatistics(
+		CommandScheduler::Statistics statistics[CommandScheduler::prioritiesCount])
+{
+	scheduler.takeStatistics(statistics);
+}
+
+qint64 ConnectionManager::takePeakBytesToWrite()
+{
+	return peakBytesToWrite.exchange(0);
+}
+
+void ConnectionManager::setDeadManTimeout(int milliseconds)
+{
+	deadManWatchdog.setTimeout(milliseconds);
+}
+
+int ConnectionManager::heartbeatInterval() const
+{
+	return deadManWatchdog.heartbeatInterval();
+}
+
+void ConnectionManager::heartbeat()
+{
+	deadManWatchdog.heartbeat();
+}
+
+void ConnectionManager::releaseHeldPads(qint64 silenceMs)
+{
+	bool isReleased = false;
+	QMutexLocker locker(&inputStateMutex);
+	for (int i = 0; i < GamepadState::padsCount; ++i) {
+		if (!robotState.pads[i].isHeld && !inputState.pads[i].isHeld) {
+			continue;
+		}
+
+		// input state is released too, otherwise streaming would send held position again
+		GamepadCommand release;
+		release.type = GamepadCommand::Type::padUp;
+		release.id = i + 1;
+		inputState.apply(release);
+		if (!isStreaming) {
+			// through scheduler, so positions of the pad that wait there are dropped
+			scheduler.push(release.toLine(), release, 0);
+		}
+
+		isReleased = true;
+	}
+
+	const bool isStreamed = isStreaming;
+	locker.unlock();
+	if (!isReleased) {
+		return;
+	}
+
+	if (isStreamed) {
+		sendStateChanges();
+	} else {
+		writeScheduled();
+	}
+
+	Metrics::add(Metrics::deadManReleases);
+	Metrics::set(Metrics::deadManDetectionMs, silenceMs);
+	emit padsReleased(silenceMs);
+}
+
 void ConnectionManager::write(const QString &data)
 {
-	qint64 result = socket->write(data.toLatin1().data());
+	writeCommand(data.toLatin1());
+}
+
+void ConnectionManager::handleStateChanged(QAbstractSocket::SocketState state)
+{
+	if (state == QAbstractSocket::ConnectedState) {
+		resync();
+		deadManWatchdog.start();
+		telemetry.reset();
+		telemetryTimer.start();
+	} else if (isSocketConnected) {
+		{
+			QMutexLocker locker(&inputStateMutex);
+			isSocketConnected = false;
+		}
+
+		deadManWatchdog.stop();
+		publishTelemetry();
+		telemetryTimer.stop();
+		// robot would get them late, and state is resent after reconnection anyway
+		scheduler.clear();
+	}
+}
+
+void ConnectionManager::resync()
+{
+	const qint64 linkUpNs = CommandScheduler::timestamp();
+	// robot forgets state when connection is lost, commands queued before that are stale
+	robotState = GamepadState();
+	scheduler.clear();
+
+	QList<QByteArray> commands;
+	{
+		QMutexLocker locker(&inputStateMutex);
+		isSocketConnected = true;
+		// presses of buttons are not state, old ones are not repeated
+		inputState.buttonPresses.clear();
+		commands = inputState.changesSince(robotState);
+	}
+
+	if (commands.isEmpty()) {
+		return;
+	}
+
+	TraceSpan span("resync");
+	for (const QByteArray &command : commands) {
+		writeCommand(command);
+	}
+
+	resyncStartNs = linkUpNs;
+	resyncCommands = commands.size();
+}
+
+void ConnectionManager::handleBytesWritten()
+{
+	if (resyncStartNs >= 0 && socket->bytesToWrite() == 0) {
+		// state has left gamepad, the rest of recovery time is network and robot
+		const qint64 recoveryNs = CommandScheduler::timestamp() - resyncStartNs;
+		resyncStartNs = -1;
+		Metrics::add(Metrics::stateResyncs);
+		Metrics::set(Metrics::resyncMs, recoveryNs / 1e6);
+		emit stateResynced(resyncCommands, recoveryNs / 1000);
+	}
+
+	writeScheduled();
+}
+
+void ConnectionManager::readTelemetry()
+{
+	const quint64 lines = telemetry.lines();
+	const quint64 invalidLines = telemetry.invalidLines();
+	const quint64 droppedSamples = telemetry.droppedSamples();
+	telemetry.read(socket);
+	Metrics::add(Metrics::telemetryLines, telemetry.lines() - lines);
+	Metrics::add(Metrics::telemetryInvalidLines, telemetry.invalidLines() - invalidLines);
+	Metrics::add(Metrics::telemetryDroppedSamples, telemetry.droppedSamples() - droppedSamples);
+}
+
+void ConnectionManager::publishTelemetry()
+{
+	if (telemetry.hasSamples()) {
+		emit telemetryReceived(telemetry.takeSamples());
+	}
+}
+
+void ConnectionManager::writeScheduled()
+{
+	scheduler.beginTaking();
+	CommandScheduler::Command command;
+	while (scheduler.take(socket->bytesToWrite() <= maxBytesToWrite, command)) {
+		if (command.traceId != 0) {
+			Tracer::asyncEnd("queued hop", command.traceId);
+		}
+
+		writeCommand(command.data);
+	}
+}
+
+void ConnectionManager::setStreamingRate(int rate)
+{
+	{
+		QMutexLocker locker(&inputStateMutex);
+		isStreaming = rate > 0;
+	}
+
+	if (rate > 0) {
+		streamTimer.start(qMax(1, 1000 / rate));
+	} else {
+		// changes that came after the last tick would be lost otherwise
+		sendStateChanges();
+		streamTimer.stop();
+	}
+}
+
+void ConnectionManager::sendStateChanges()
+{
+	if (!isConnected()) {
+		// robot gets positions that were set meanwhile by the first tick after connection, but not old presses
+		QMutexLocker locker(&inputStateMutex);
+		inputState.buttonPresses.clear();
+		return;
+	}
+
+	GamepadState state;
+	{
+		QMutexLocker locker(&inputStateMutex);
+		state = inputState;
+		inputState.buttonPresses.clear();
+	}
+
+	TraceSpan span("sendStateChanges");
+	for (const QByteArray &command : state.changesSince(robotState)) {
+		writeCommand(command);
+	}
+}
+
+void ConnectionManager::writeCommand(const QByteArray &command)
+{
+	TraceSpan span("socket->write");
+	qint64 result = socket->write(command);
+	const GamepadCommand parsed = GamepadCommand::parse(command);
+	Metrics::addCommand(parsed);
+	if (parsed.type != GamepadCommand::Type::button) {
+		// presses of buttons are not kept in state of robot
+		robotState.apply(parsed);
+	}
+
+	const qint64 bytesToWrite = socket->bytesToWrite();
+	if (bytesToWrite > peakBytesToWrite.load(std::memory_order_relaxed)) {
+		// only connection thread writes, so the value is not lost between load and store
+		peakBytesToWrite.store(bytesToWrite, std::memory_order_relaxed);
+	}
+
+	if (result == -1) {
+		Metrics::add(Metrics::writeFailures);
+	} else {
+		Metrics::add(Metrics::bytesSent, static_cast<quint64>(result));
+	}
+
+	if (journal) {
+		journal->append(command, CommandJournal::timestamp());
+	}
+
 	emit dataWasWritten(static_cast<int>(result));
 }
 
@@ -66,20 +390,35 @@ QString ConnectionManager::getGamepadIp() const
 
 void ConnectionManager::connectToHost()
 {
+	if (socket->state() == QAbstractSocket::ConnectedState && socket->peerName() == gamepadIp
+			&& socket->peerPort() == gamepadPort) {
+		// socket that was connected in advance is adopted
+		return;
+	}
+
 	const int timeout = 3 * 1000;
+	Metrics::add(Metrics::connectionAttempts);
 	socket->connectToHost(gamepadIp, gamepadPort);
-	if (!socket->waitForConnected(timeout))
+	if (!socket->waitForConnected(timeout)) {
+		Metrics::add(Metrics::connectionFailures);
 		emit connectionFailed();
+	}
 }
 
 void ConnectionManager::disconnectFromHost()
 {
+	deadManWatchdog.stop();
+	if (streamTimer.isActive()) {
+		// releases of keys made right before disconnection should reach robot
+		sendStateChanges();
+	}
+
 	socket->disconnectFromHost();
 }
 
 void ConnectionManager::setCameraIp(const QString &value)
 {
-	cameraIp = value;
+	cameraIp = value.trimmed();
 }
 
 QString ConnectionManager::getCameraPort() const
@@ -99,5 +438,11 @@ void ConnectionManager::setGamepadPort(const quint16 &value)
 
 void ConnectionManager::setGamepadIp(const QString &value)
 {
-	gamepadIp = value;
+	// trimmed like in PreConnector, so the address matches peer name of the socket connected in advance
+	gamepadIp = value.trimmed();
+}
+
+void ConnectionManager::setJournal(CommandJournal *value)
+{
+	journal = value;
 }
@@ -20,6 +20,17 @@
 
 #include <QTcpSocket>
 #include <QIODevice>
+#include <QMutex>
+#include <QTimer>
+
+#include <atomic>
+
+#include "commandScheduler.h"
+#include "deadManWatchdog.h"
+#include "gamepadState.h"
+#include "telemetryReader.h"
+
+class CommandJournal;
 
 
 class ConnectionManager : public QObject
@@ -50,21 +61,109 @@ public:
 
 	quint16 getGamepadPort() const;
 
+	/// every written command is appended to journal, should be set before connecting
+	void setJournal(CommandJournal *value);
+
+	/// passes command to CommandScheduler and wakes connection thread to write it, or only updates state
+	/// if state is streamed; can be called from any thread
+	void send(const QString &command);
+
+	/// statistics of scheduler since previous call, can be called from any thread
+	void takeSchedulerStatistics(CommandScheduler::Statistics statistics[CommandScheduler::prioritiesCount]);
+
+	/// the largest amount of data that waited in socket after a write since previous call, can be called from any
+	/// thread. Unlike waits in scheduler it grows in streaming mode too, where commands are written directly
+	qint64 takePeakBytesToWrite();
+
+	/// held pads are released if input side does not call heartbeat() for so long, 0 turns it off;
+	/// should be set before connecting
+	void setDeadManTimeout(int milliseconds);
+
+	/// interval of heartbeat() calls that keeps pads from being released, 0 if they are not needed
+	int heartbeatInterval() const;
+
+	/// can be called from any thread
+	void heartbeat();
+
+	/// takes socket that is already connected to robot instead of connecting on connectToHost(),
+	/// is called from thread of the socket, socket should not have parent
+	void adoptSocket(QTcpSocket *connectedSocket);
+
 public slots:
 	void connectToHost();
 	void disconnectFromHost();
+
+	/// writes command right away, bypassing scheduler
 	void write(const QString &);
 
+	/// with rate > 0 connection thread sends changes of state of pads, wheel and buttons that many times
+	/// per second instead of sending commands as they come, 0 turns streaming off
+	void setStreamingRate(int rate);
+
 signals:
 	void stateChanged(QAbstractSocket::SocketState socketState);
 	void dataWasWritten(int);
 	void connectionFailed();
 
+	/// held pads were released because input side stopped heartbeats for silenceMs
+	void padsReleased(qint64 silenceMs);
+
+	/// state held by input was resent after connection, recovery is time from link up until it left socket
+	void stateResynced(int commands, qint64 recoveryUs);
+
+	/// telemetry that robot has sent since previous signal, is emitted about 30 times per second
+	void telemetryReceived(const QVector<TelemetrySample> &samples);
+
+private slots:
+	void replaceSocket(QTcpSocket *connectedSocket);
+	void handleStateChanged(QAbstractSocket::SocketState state);
+	void handleBytesWritten();
+	void readTelemetry();
+	void publishTelemetry();
+
+	/// writes urgent commands, and continuous ones while socket keeps up with them
+	void writeScheduled();
+
+	void releaseHeldPads(qint64 silenceMs);
+
+	/// writes commands that turn state of robot into state of input
+	void sendStateChanges();
+
 private:
+	void connectSocket();
+
+	/// resends state of input to robot that has just connected
+	void resync();
+	void writeCommand(const QByteArray &command);
+
 	QTcpSocket *socket;
 	QString cameraIp;
 	QString cameraPort;
 
 	QString gamepadIp;
 	quint16 gamepadPort;
+
+	CommandJournal *journal;
+	CommandScheduler scheduler;
+	DeadManWatchdog deadManWatchdog;
+
+	/// state that written commands have set on robot, is used only by connection thread
+	GamepadState robotState;
+
+	/// state that input wants robot to have, guards isStreaming and isSocketConnected too
+	QMutex inputStateMutex;
+	GamepadState inputState;
+	bool isStreaming;
+	QTimer streamTimer;
+
+	/// is read by other threads, unlike state of socket
+	std::atomic<bool> isSocketConnected;
+	std::atomic<qint64> peakBytesToWrite;
+
+	/// link up time of resync that is not written to network yet, -1 if there is none
+	qint64 resyncStartNs;
+	int resyncCommands;
+
+	TelemetryReader telemetry;
+	QTimer telemetryTimer;
 };
@@ -0,0 +1,89 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "deadManWatchdog.h"
+
+#include <chrono>
+
+DeadManWatchdog::DeadManWatchdog(QObject *parent)
+	: QObject(parent)
+	// timer is a child, so it moves to connection thread together with watchdog
+	, mTimer(this)
+	, mTimeoutMs(0)
+	, mLastHeartbeatNs(0)
+	, mIsStalled(false)
+{
+	mTimer.setTimerType(Qt::PreciseTimer);
+	connect(&mTimer, SIGNAL(timeout()), this, SLOT(check()));
+}
+
+void DeadManWatchdog::setTimeout(int milliseconds)
+{
+	mTimeoutMs = qMax(0, milliseconds);
+}
+
+int DeadManWatchdog::timeout() const
+{
+	return mTimeoutMs;
+}
+
+int DeadManWatchdog::heartbeatInterval() const
+{
+	return mTimeoutMs > 0 ? qMax(1, mTimeoutMs / checksPerTimeout) : 0;
+}
+
+void DeadManWatchdog::heartbeat()
+{
+	mLastHeartbeatNs.store(timestamp(), std::memory_order_relaxed);
+}
+
+void DeadManWatchdog::start()
+{
+	mIsStalled = false;
+	if (mTimeoutMs == 0) {
+		mTimer.stop();
+		return;
+	}
+
+	heartbeat();
+	mTimer.start(heartbeatInterval());
+}
+
+void DeadManWatchdog::stop()
+{
+	mTimer.stop();
+}
+
+void DeadManWatchdog::check()
+{
+	const qint64 silenceMs = (timestamp() - mLastHeartbeatNs.load(std::memory_order_relaxed)) / 1000000;
+	if (silenceMs < mTimeoutMs) {
+		mIsStalled = false;
+		return;
+	}
+
+	if (!mIsStalled) {
+		mIsStalled = true;
+		emit stalled(silenceMs);
+	}
+}
+
+qint64 DeadManWatchdog::timestamp()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,70 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+
+#include <atomic>
+
+/// Notices that input side stopped working, e.g. GUI thread is blocked by a modal dialog while a pad is held.
+/// Input thread calls heartbeat() by its own timer, so heartbeats stop together with the thread. Watchdog lives
+/// in connection thread and checks heartbeats timeout / checksPerTimeout times per timeout, so a stall is detected
+/// no later than timeout * (1 + 1 / checksPerTimeout) after the last heartbeat.
+class DeadManWatchdog : public QObject
+{
+	Q_OBJECT
+
+private:
+	DeadManWatchdog(const DeadManWatchdog &other);
+	DeadManWatchdog & operator=(const DeadManWatchdog &other);
+
+public:
+	static const int checksPerTimeout = 4;
+
+	explicit DeadManWatchdog(QObject *parent = nullptr);
+
+	/// 0 turns watchdog off, takes effect at next start()
+	void setTimeout(int milliseconds);
+	int timeout() const;
+
+	/// interval of heartbeats that input side should keep, 0 if watchdog is off
+	int heartbeatInterval() const;
+
+	/// can be called from any thread
+	void heartbeat();
+
+public slots:
+	void start();
+	void stop();
+
+signals:
+	/// emitted once per stall, silence is time since the last heartbeat
+	void stalled(qint64 silenceMs);
+
+private slots:
+	void check();
+
+private:
+	static qint64 timestamp();
+
+	QTimer mTimer;
+	std::atomic<int> mTimeoutMs;
+	std::atomic<qint64> mLastHeartbeatNs;
+	bool mIsStalled;
+};
@@ -0,0 +1,88 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "frameRingBuffer.h"
+
+FrameRingBuffer::FrameRingBuffer(qint64 windowMs, qint64 byteBudget)
+	: mWindowMs(windowMs)
+	, mByteBudget(byteBudget)
+	, mBytesUsed(0)
+{
+}
+
+void FrameRingBuffer::setWindow(qint64 windowMs)
+{
+	mWindowMs = windowMs;
+	evict();
+}
+
+void FrameRingBuffer::setByteBudget(qint64 byteBudget)
+{
+	mByteBudget = byteBudget;
+	evict();
+}
+
+void FrameRingBuffer::push(const BufferedFrame &frame)
+{
+	if (frame.jpeg.size() > mByteBudget) {
+		return;
+	}
+
+	mFrames.enqueue(frame);
+	mBytesUsed += frame.jpeg.size();
+	evict();
+}
+
+QVector<BufferedFrame> FrameRingBuffer::frames() const
+{
+	QVector<BufferedFrame> result;
+	result.reserve(mFrames.size());
+	for (const BufferedFrame &frame : mFrames) {
+		result.append(frame);
+	}
+
+	return result;
+}
+
+int FrameRingBuffer::size() const
+{
+	return mFrames.size();
+}
+
+qint64 FrameRingBuffer::bytesUsed() const
+{
+	return mBytesUsed;
+}
+
+void FrameRingBuffer::clear()
+{
+	mFrames.clear();
+	mBytesUsed = 0;
+}
+
+void FrameRingBuffer::evict()
+{
+	if (mFrames.isEmpty()) {
+		return;
+	}
+
+	const qint64 newest = mFrames.last().timestamp;
+	while (!mFrames.isEmpty()
+			&& (mBytesUsed > mByteBudget || newest - mFrames.head().timestamp > mWindowMs)) {
+		mBytesUsed -= mFrames.dequeue().jpeg.size();
+	}
+}
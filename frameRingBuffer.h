@@ -0,0 +1,60 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QByteArray>
+#include <QQueue>
+#include <QVector>
+
+/// Compressed frame of camera stream as it was received from robot.
+struct BufferedFrame
+{
+	QByteArray jpeg;
+	quint64 sequence;
+
+	/// monotonic time of arrival in milliseconds
+	qint64 timestamp;
+};
+
+/// Keeps compressed frames received during the last period of time, so the moment before some event can be saved.
+/// Both period of time and total size of kept frames are bounded, the oldest frames are dropped first.
+class FrameRingBuffer
+{
+public:
+	FrameRingBuffer(qint64 windowMs, qint64 byteBudget);
+
+	void setWindow(qint64 windowMs);
+	void setByteBudget(qint64 byteBudget);
+
+	void push(const BufferedFrame &frame);
+
+	/// returns kept frames starting from the oldest one
+	QVector<BufferedFrame> frames() const;
+
+	int size() const;
+	qint64 bytesUsed() const;
+	void clear();
+
+private:
+	void evict();
+
+	QQueue<BufferedFrame> mFrames;
+	qint64 mWindowMs;
+	qint64 mByteBudget;
+	qint64 mBytesUsed;
+};
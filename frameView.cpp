@@ -0,0 +1,74 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "frameView.h"
+
+#include <QPainter>
+#include <QResizeEvent>
+
+FrameView::FrameView(QWidget *parent)
+	: QWidget(parent)
+{
+	setAttribute(Qt::WA_OpaquePaintEvent);
+	setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+}
+
+QImage FrameView::frame() const
+{
+	return mFrame;
+}
+
+QSize FrameView::sizeHint() const
+{
+	return QSize(640, 480);
+}
+
+void FrameView::setFrame(const QImage &image)
+{
+	mFrame = image;
+	update();
+}
+
+void FrameView::clear()
+{
+	mFrame = QImage();
+	update();
+}
+
+void FrameView::resizeEvent(QResizeEvent *event)
+{
+	QWidget::resizeEvent(event);
+	emit resized(event->size() * devicePixelRatioF());
+}
+
+void FrameView::paintEvent(QPaintEvent *event)
+{
+	Q_UNUSED(event)
+
+	QPainter painter(this);
+	painter.fillRect(rect(), Qt::black);
+	if (mFrame.isNull()) {
+		return;
+	}
+
+	QSize size = mFrame.size();
+	size.scale(this->size(), Qt::KeepAspectRatio);
+	QRect target(QPoint(0, 0), size);
+	target.moveCenter(rect().center());
+	painter.setRenderHint(QPainter::SmoothPixmapTransform);
+	painter.drawImage(target, mFrame);
+}
@@ -0,0 +1,54 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QWidget>
+#include <QImage>
+
+/// Widget that shows decoded frames of robot camera, frame is scaled to widget keeping aspect ratio.
+class FrameView : public QWidget
+{
+	Q_OBJECT
+
+private:
+	FrameView(const FrameView &other);
+	FrameView & operator=(const FrameView &other);
+
+public:
+	explicit FrameView(QWidget *parent = nullptr);
+
+	/// returns last shown frame
+	QImage frame() const;
+
+	QSize sizeHint() const override;
+
+public slots:
+	void setFrame(const QImage &image);
+	void clear();
+
+signals:
+	/// emitted when size of widget in device pixels changes
+	void resized(const QSize &size);
+
+protected:
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+
+private:
+	QImage mFrame;
+};
@@ -21,20 +21,37 @@
 #include <QtWidgets/QMessageBox>
 #include <QtGui/QKeyEvent>
 
-#include <QNetworkRequest>
-#include <QMediaContent>
 #include <QFontDatabase>
+#include <QSettings>
+#include <QDir>
+#include <QLocale>
+
+#include "startupProfiler.h"
+#include "tracer.h"
+#include "metrics.h"
+#include "commandProtocol.h"
 
 GamepadForm::GamepadForm()
 	: QWidget()
 	, mUi(new Ui::GamepadForm())
+	, mTranslator(nullptr)
 	, strategy(Strategy::getStrategy(Strategies::standartStrategy))
-{
+	, mAreStatusPixmapsLoaded(false)
+	, mStreamReader(nullptr)
+	, mFrameView(nullptr)
+	, mFrameRing(5 * 1000, 64 * 1024 * 1024)
+	, mBurstFrames(0)
+	, mBurstFramesLeft(0)
+{
+	StartupProfiler::mark("strategy");
 	// Here all GUI widgets are created and initialized.
 	mUi->setupUi(this);
-	this->installEventFilter(this);
+	StartupProfiler::mark("setupUi");
+	mInputDispatcher.setStrategy(strategy);
+	this->installEventFilter(&mInputDispatcher);
 	setUpGamepadForm();
 	startThread();
+	StartupProfiler::mark("connection thread");
 }
 
 GamepadForm::~GamepadForm()
@@ -45,6 +62,8 @@ GamepadForm::~GamepadForm()
 	thread.quit();
 	// waiting thread to quit
 	thread.wait();
+	mMetricsThread.quit();
+	mMetricsThread.wait();
 }
 
 void GamepadForm::startController(QStringList args)
@@ -63,103 +82,326 @@ void GamepadForm::startController(QStringList args)
 	emit dataReceivedFromCommandLine();
 }
 
+void GamepadForm::setJournal(CommandJournal *journal)
+{
+	connectionManager.setJournal(journal);
+}
+
+bool GamepadForm::listenAutomation(const QString &path, QString &errorString)
+{
+	if (!mAutomationServer.listen(path)) {
+		errorString = mAutomationServer.errorString();
+		return false;
+	}
+
+	// commands of other programs go the same way as commands of strategies
+	connect(&mAutomationServer, SIGNAL(commandPrepared(QString)), this, SLOT(sendCommand(QString)));
+	mAutomationServer.setStatusProvider([this]() {
+		QJsonObject status;
+		status.insert("connected", connectionManager.isConnected());
+		status.insert("robot", connectionManager.getGamepadIp());
+		status.insert("port", connectionManager.getGamepadPort());
+		status.insert("streaming", mStreamingAction->isChecked());
+		return status;
+	});
+	return true;
+}
+
+void GamepadForm::setTraceFile(const QString &fileName)
+{
+	mTraceFile = fileName;
+	mDumpTraceAction->setVisible(Tracer::isEnabled() && !fileName.isEmpty());
+}
+
 void GamepadForm::setUpGamepadForm()
 {
 	createMenu();
-	setFontToPadButtons();
+	StartupProfiler::mark("menu");
 	setUpControlButtonsHash();
 	createConnection();
+	StartupProfiler::mark("buttons and connections");
 	setVideoController();
 	setLabels();
 	setImageControl();
+	setUpMetrics();
+	StartupProfiler::mark("labels and image control");
 	retranslate();
+	StartupProfiler::mark("retranslate");
+
+	// font for pad buttons is loaded when window is already shown
+	QTimer::singleShot(0, this, SLOT(setFontToPadButtons()));
 }
 
 void GamepadForm::setVideoController()
 {
-	player = new QMediaPlayer(this, QMediaPlayer::StreamPlayback);
-	connect(player, SIGNAL(mediaStatusChanged(QMediaPlayer::MediaStatus)), this, SLOT(handleMediaStatusChanged(QMediaPlayer::MediaStatus)));
+	mVideoMetricsLabel = new QLabel(this);
+	mVideoMetricsLabel->setVisible(false);
+	mUi->verticalLayout->addWidget(mVideoMetricsLabel);
+	mUi->verticalLayout->setAlignment(mVideoMetricsLabel, Qt::AlignCenter);
 
-	videoWidget = new QVideoWidget(this);
-	player->setVideoOutput(videoWidget);
-	videoWidget->setMinimumSize(320, 240);
-	videoWidget->setVisible(false);
-	mUi->verticalLayout->addWidget(videoWidget);
-	mUi->verticalLayout->setAlignment(videoWidget, Qt::AlignCenter);
+	// telemetry of robot is shown when robot sends some
+	mTelemetryLabel = new QLabel(this);
+	mTelemetryLabel->setVisible(false);
+	mUi->verticalLayout->addWidget(mTelemetryLabel);
+	mUi->verticalLayout->setAlignment(mTelemetryLabel, Qt::AlignCenter);
+
+	QSettings settings;
+	mPlotPanel = new PlotPanel(this);
+	mPlotPanel->setWindow(settings.value("plot/windowSeconds", 10).toInt());
+	mPlotPanel->setSeriesCapacity(settings.value("plot/samplesPerSeries", 256 * 1024).toInt());
+	mPlotPanel->setVisible(false);
+	mUi->verticalLayout->addWidget(mPlotPanel);
+
+	connect(&mVideoMetricsTimer, SIGNAL(timeout()), this, SLOT(updateVideoMetrics()));
+	mVideoMetricsTimer.start(1000);
 
-	movie.setFileName(":/images/loading.gif");
 	mUi->loadingMediaLabel->setVisible(false);
+	mUi->invalidMediaLabel->setVisible(false);
+}
+
+void GamepadForm::createVideoPipeline()
+{
+	mStreamReader = new MjpegStreamReader(this);
+	connect(mStreamReader, SIGNAL(started()), this, SLOT(handleStreamStarted()));
+	connect(mStreamReader, SIGNAL(failed(QString)), this, SLOT(handleStreamFailed()));
+	connect(mStreamReader, SIGNAL(finished()), this, SLOT(handleStreamFinished()));
+	connect(mStreamReader, SIGNAL(frameReceived(QByteArray, quint64, qint64))
+			, this, SLOT(handleFrameReceived(QByteArray, quint64, qint64)));
+
+	QSettings settings;
+	const bool isSnapshotMode = settings.value("video/snapshotMode", false).toBool();
+	mStreamReader->setMode(isSnapshotMode ? MjpegStreamReader::Mode::snapshot : MjpegStreamReader::Mode::stream);
+	mStreamReader->setMaxSnapshotRate(settings.value("video/snapshotMaxFps", 10).toInt());
+	mVideoDecoder.setThreadCount(settings.value("video/decodeThreads", QThread::idealThreadCount()).toInt());
+	mVideoDecoder.setLatestOnly(settings.value("video/latestOnly", true).toBool());
+	connect(&mVideoDecoder, SIGNAL(frameDecoded(QImage, quint64)), this, SLOT(showFrame(QImage, quint64)));
+
+	mVideoWatchdog.setStallTimeout(settings.value("video/stallTimeoutMs", 3000).toInt());
+	mVideoWatchdog.setMaxBackoff(settings.value("video/maxReconnectBackoffMs", 30 * 1000).toInt());
+	connect(&mVideoWatchdog, SIGNAL(reconnectRequested()), this, SLOT(reconnectVideoStream()));
+
+	bool isReducedResolution = settings.value("video/reducedResolution", true).toBool();
+	if (settings.value("sharedMemory/enabled", false).toBool()) {
+		const bool isOpened = mSharedFramePublisher.open(
+				settings.value("sharedMemory/name", "/trik-gamepad-frames").toString()
+				, settings.value("sharedMemory/slots", 4).toInt()
+				, settings.value("sharedMemory/slotSize", 1920 * 1080 * 4).toInt());
+		if (isOpened) {
+			connect(&mVideoDecoder, SIGNAL(frameDecoded(QImage, quint64)), &mSharedFramePublisher, SLOT(publishImage(QImage)));
+			// external processes usually need frames in original resolution regardless of window size
+			isReducedResolution = isReducedResolution && !settings.value("sharedMemory/fullResolution", true).toBool();
+		} else {
+			qWarning("%s", qPrintable(mSharedFramePublisher.errorString()));
+		}
+	}
+
+	mFrameView = new FrameView(this);
+	mFrameView->setMinimumSize(320, 240);
+	mFrameView->setVisible(false);
+	if (isReducedResolution) {
+		// decoding resolution follows size of the view, so small window does not pay for full decoding
+		connect(mFrameView, &FrameView::resized, &mVideoDecoder, &VideoDecoder::setTargetSize);
+	}
+	mUi->verticalLayout->insertWidget(mUi->verticalLayout->indexOf(mVideoMetricsLabel), mFrameView);
+	mUi->verticalLayout->setAlignment(mFrameView, Qt::AlignCenter);
+
+	movie.setFileName(":/images/loading.gif");
 	mUi->loadingMediaLabel->setMovie(&movie);
 
 	QPixmap pixmap(":/images/noVideoSign.png");
 	mUi->invalidMediaLabel->setPixmap(pixmap);
+}
 
-	mUi->loadingMediaLabel->setVisible(false);
-	mUi->invalidMediaLabel->setVisible(false);
+void GamepadForm::setVideoState(VideoState state)
+{
+	mTakeImageAction->setEnabled(state == VideoState::playing);
+	mSaveFramesAction->setEnabled(state == VideoState::playing);
+	movie.setPaused(state != VideoState::loading);
 
+	mUi->loadingMediaLabel->setVisible(state == VideoState::loading);
+	mUi->invalidMediaLabel->setVisible(state == VideoState::invalid);
+	mUi->label->setVisible(state == VideoState::noVideo);
+	mFrameView->setVisible(state == VideoState::playing);
+	if (state != VideoState::playing) {
+		mFrameView->clear();
+	}
 }
 
-void GamepadForm::handleMediaStatusChanged(QMediaPlayer::MediaStatus status)
+void GamepadForm::startVideoStream()
 {
-	mTakeImageAction->setEnabled(false);
-	movie.setPaused(true);
-	switch (status) {
-	case QMediaPlayer::StalledMedia:
-	case QMediaPlayer::LoadedMedia:
-	case QMediaPlayer::BufferingMedia:
-		player->play();
-		mTakeImageAction->setEnabled(true);
-		mUi->loadingMediaLabel->setVisible(false);
-		mUi->invalidMediaLabel->setVisible(false);
-		mUi->label->setVisible(false);
-		videoWidget->setVisible(true);
-		break;
+	if (!mStreamReader) {
+		// video is not needed until camera is configured, so it is not created at startup
+		createVideoPipeline();
+	}
 
-	case QMediaPlayer::LoadingMedia:
-		mUi->invalidMediaLabel->setVisible(false);
-		mUi->label->setVisible(false);
-		videoWidget->setVisible(false);
-		mUi->loadingMediaLabel->setVisible(true);
-		movie.setPaused(false);
-		break;
+	const QString ip = connectionManager.getCameraIp();
+	const QString port = connectionManager.getCameraPort();
+	const bool isSnapshotMode = mStreamReader->mode() == MjpegStreamReader::Mode::snapshot;
+	const QUrl url("http://" + ip + ":" + port + (isSnapshotMode ? "/?action=snapshot" : "/?action=stream"));
+
+	if (!mStreamReader->isActive() || mStreamReader->url() != url) {
+		mFrameRing.clear();
+		mVideoDecoder.reset();
+		mStreamReader->start(url);
+		mVideoWatchdog.arm();
+		setVideoState(VideoState::loading);
+	}
+}
 
-	case QMediaPlayer::InvalidMedia:
-		mUi->loadingMediaLabel->setVisible(false);
-		mUi->label->setVisible(false);
-		videoWidget->setVisible(false);
-		mUi->invalidMediaLabel->setVisible(true);
-		break;
+void GamepadForm::reconnectVideoStream()
+{
+	Metrics::add(Metrics::videoReconnects);
+	mVideoDecoder.reset();
+	mStreamReader->start(mStreamReader->url());
+}
 
-	case QMediaPlayer::NoMedia:
-	case QMediaPlayer::EndOfMedia:
-		mUi->loadingMediaLabel->setVisible(false);
-		mUi->invalidMediaLabel->setVisible(false);
-		videoWidget->setVisible(false);
-		mUi->label->setVisible(true);
-	default:
-		break;
+void GamepadForm::handleStreamStarted()
+{
+	setVideoState(VideoState::playing);
+}
+
+void GamepadForm::handleStreamFailed()
+{
+	mVideoWatchdog.streamLost();
+	setVideoState(VideoState::invalid);
+	finishBurst();
+}
+
+void GamepadForm::handleStreamFinished()
+{
+	mVideoWatchdog.streamLost();
+	setVideoState(VideoState::noVideo);
+	finishBurst();
+}
+
+void GamepadForm::finishBurst()
+{
+	if (mBurstFramesLeft > 0) {
+		// frames of burst are not going to come
+		mBurstFramesLeft = 0;
+		mSnapshotExporter->finishSession();
 	}
 }
 
-void GamepadForm::startVideoStream()
+void GamepadForm::handleFrameReceived(const QByteArray &jpeg, quint64 sequence, qint64 timestamp)
 {
-	const QString ip = connectionManager.getCameraIp();
-	const QString port = connectionManager.getCameraPort();
-	const auto status = player->mediaStatus();
+	TraceSpan span("frame received", sequence);
+	mVideoWatchdog.frameArrived();
+	mLastFrame = jpeg;
+	mFrameRing.push({jpeg, sequence, timestamp});
+	if (mBurstFramesLeft > 0) {
+		--mBurstFramesLeft;
+		mSnapshotExporter->exportFrame({jpeg, sequence, timestamp});
+		if (mBurstFramesLeft == 0) {
+			mSnapshotExporter->finishSession();
+		}
+	}
 
-	if (status == QMediaPlayer::NoMedia || status == QMediaPlayer::EndOfMedia || status == QMediaPlayer::InvalidMedia) {
-		const QString url = "http://" + ip + ":" + port + "/?action=stream";
-		//QNetworkRequest nr = QNetworkRequest(url);
-		//nr.setPriority(QNetworkRequest::LowPriority);
-		//nr.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysCache);
-		player->setMedia(QUrl(url));
+	mVideoDecoder.submit(jpeg, sequence);
+}
+
+void GamepadForm::showFrame(const QImage &image, quint64 sequence)
+{
+	TraceSpan span("present", sequence);
+	if (mStreamReader->isActive()) {
+		mFrameView->setFrame(image);
+	}
+}
+
+void GamepadForm::setVideoMetricsVisible(bool isVisible)
+{
+	mVideoMetricsLabel->setVisible(isVisible);
+	updateVideoMetrics();
+}
+
+void GamepadForm::setPlotVisible(bool isVisible)
+{
+	mPlotPanel->clear();
+	mPlotPanel->setVisible(isVisible);
+}
+
+void GamepadForm::setSnapshotMode(bool isSnapshotMode)
+{
+	QSettings().setValue("video/snapshotMode", isSnapshotMode);
+	if (!mStreamReader) {
+		// mode is taken from settings when camera is configured
+		return;
 	}
+
+	// url of camera differs between modes, so video is reopened even if it is reconnecting now
+	mStreamReader->setMode(isSnapshotMode ? MjpegStreamReader::Mode::snapshot : MjpegStreamReader::Mode::stream);
+	startVideoStream();
+}
+
+void GamepadForm::updateVideoMetrics()
+{
+	mVideoMetrics = mVideoDecoder.takeMetrics();
+	mVideoMetrics.reconnects = mVideoWatchdog.reconnects();
+	mVideoMetrics.lastReconnectMs = mVideoWatchdog.lastReconnectTimeMs();
+	qint64 averageInputLatencyNs = 0;
+	qint64 maxInputLatencyNs = 0;
+	mInputDispatcher.takeLatency(averageInputLatencyNs, maxInputLatencyNs);
+	CommandScheduler::Statistics scheduler[CommandScheduler::prioritiesCount];
+	connectionManager.takeSchedulerStatistics(scheduler);
+	const CommandScheduler::Statistics &urgent = scheduler[CommandScheduler::urgent];
+	const CommandScheduler::Statistics &continuous = scheduler[CommandScheduler::continuous];
+	if (mStreamReader) {
+		// positions of pads wait in scheduler while control socket is busy, or in the socket itself when they are
+		// streamed, polling backs off then
+		mStreamReader->setControlLoad(continuous.averageWaitMs, connectionManager.takePeakBytesToWrite());
+		mVideoMetrics.snapshotIntervalMs = mStreamReader->snapshotIntervalMs();
+		mVideoMetrics.snapshotDownloadMs = mStreamReader->snapshotDownloadMs();
+	}
+
+	Metrics::set(Metrics::receivedFps, mVideoMetrics.receivedFps);
+	Metrics::set(Metrics::presentedFps, mVideoMetrics.presentedFps);
+	Metrics::set(Metrics::decodedFps, mVideoMetrics.decodedFps);
+	Metrics::set(Metrics::decodeMs, mVideoMetrics.averageDecodeMs);
+	Metrics::set(Metrics::snapshotIntervalMs, mVideoMetrics.snapshotIntervalMs);
+	// decoder counts dropped frames from its start, only this thread adds to the counter
+	const quint64 reportedDroppedFrames = Metrics::value(Metrics::droppedFrames);
+	if (mVideoMetrics.droppedFrames > reportedDroppedFrames) {
+		Metrics::add(Metrics::droppedFrames, mVideoMetrics.droppedFrames - reportedDroppedFrames);
+	}
+
+	if (!mVideoMetricsLabel->isVisible()) {
+		return;
+	}
+
+	mVideoMetricsLabel->setText(tr("Received: %1 fps, shown: %2 fps, decoded: %3 fps on %4 threads "
+			"(%5 ms per frame, scale 1/%6), dropped: %7, reconnects: %8 (last took %9 ms)")
+			.arg(mVideoMetrics.receivedFps, 0, 'f', 1)
+			.arg(mVideoMetrics.presentedFps, 0, 'f', 1)
+			.arg(mVideoMetrics.decodedFps, 0, 'f', 1)
+			.arg(mVideoMetrics.decodeThreads)
+			.arg(mVideoMetrics.averageDecodeMs, 0, 'f', 1)
+			.arg(mVideoMetrics.decodeScaleDenominator)
+			.arg(mVideoMetrics.droppedFrames)
+			.arg(mVideoMetrics.reconnects)
+			.arg(mVideoMetrics.lastReconnectMs)
+			+ (mVideoMetrics.snapshotIntervalMs > 0 ? "\n" + tr("Snapshots: every %1 ms, %2 ms to download")
+			.arg(mVideoMetrics.snapshotIntervalMs)
+			.arg(mVideoMetrics.snapshotDownloadMs, 0, 'f', 1) : QString())
+			+ "\n" + tr("Key handling: %1 us on average, %2 us at most")
+			.arg(averageInputLatencyNs / 1000.0, 0, 'f', 1)
+			.arg(maxInputLatencyNs / 1000.0, 0, 'f', 1)
+			+ "\n" + tr("Urgent commands: %1 waited %2 ms on average, %3 ms at most, queue up to %4; "
+			"positions: %5 waited %6 ms on average, %7 ms at most, %8 replaced")
+			.arg(urgent.taken)
+			.arg(urgent.averageWaitMs, 0, 'f', 2)
+			.arg(urgent.maxWaitMs, 0, 'f', 2)
+			.arg(urgent.maxQueueDepth)
+			.arg(continuous.taken)
+			.arg(continuous.averageWaitMs, 0, 'f', 2)
+			.arg(continuous.maxWaitMs, 0, 'f', 2)
+			.arg(continuous.replaced));
 }
 
 void GamepadForm::checkSocket(QAbstractSocket::SocketState state)
 {
 	switch (state) {
 	case QAbstractSocket::ConnectedState:
+		loadStatusPixmaps();
 		mUi->disconnectedLabel->setVisible(false);
 		mUi->connectedLabel->setVisible(true);
 		mUi->connectingLabel->setVisible(false);
@@ -168,6 +410,7 @@ void GamepadForm::checkSocket(QAbstractSocket::SocketState state)
 		break;
 
 	case QAbstractSocket::ConnectingState:
+		loadStatusPixmaps();
 		mUi->disconnectedLabel->setVisible(false);
 		mUi->connectedLabel->setVisible(false);
 		mUi->connectingLabel->setVisible(true);
@@ -188,8 +431,55 @@ void GamepadForm::checkSocket(QAbstractSocket::SocketState state)
 
 void GamepadForm::startThread()
 {
+	QSettings settings;
+	connectionManager.setDeadManTimeout(settings.value("safety/deadManTimeoutMs", 500).toInt());
+	connect(&connectionManager, SIGNAL(padsReleased(qint64)), this, SLOT(showPadsReleased(qint64)));
+	connect(&connectionManager, SIGNAL(stateResynced(int, qint64)), this, SLOT(showStateResynced(int, qint64)));
+	connect(&connectionManager, SIGNAL(telemetryReceived(QVector<TelemetrySample>))
+			, this, SLOT(showTelemetry(QVector<TelemetrySample>)));
+	connect(&connectionManager, SIGNAL(telemetryReceived(QVector<TelemetrySample>))
+			, mPlotPanel, SLOT(addTelemetry(QVector<TelemetrySample>)));
+	// timer keeps firing in nested event loop of a dialog, where keys do not reach the form and their releases are
+	// lost, so heartbeats are sent only while the form gets input, and held pads are released by watchdog otherwise.
+	// Automation clients drive robot without the form, their pads are released when they disconnect
+	connect(&mHeartbeatTimer, &QTimer::timeout, this, [this]() {
+		if (InputDispatcher::isReceivingInput(this) || mAutomationServer.hasClients()) {
+			connectionManager.heartbeat();
+		}
+	});
+	if (connectionManager.heartbeatInterval() > 0) {
+		mHeartbeatTimer.start(connectionManager.heartbeatInterval());
+	}
+
+	thread.setObjectName("connection");
 	connectionManager.moveToThread(&thread);
 	thread.start();
+	setStreaming(mStreamingAction->isChecked());
+}
+
+void GamepadForm::showPadsReleased(qint64 silenceMs)
+{
+	qWarning("Pads were released by connection thread, input did not respond for %lld ms", silenceMs);
+}
+
+void GamepadForm::showStateResynced(int commands, qint64 recoveryUs)
+{
+	qWarning("Held keys were resent to robot after connection: %d commands in %.2f ms", commands, recoveryUs / 1000.0);
+}
+
+void GamepadForm::showTelemetry(const QVector<TelemetrySample> &samples)
+{
+	for (const TelemetrySample &sample : samples) {
+		mTelemetry.insert(sample.key, sample.value);
+	}
+
+	QStringList values;
+	for (auto value = mTelemetry.constBegin(); value != mTelemetry.constEnd(); ++value) {
+		values << QString::fromLatin1(value.key()) + ": " + QString::number(value.value(), 'g', 4);
+	}
+
+	mTelemetryLabel->setText(values.join("   "));
+	mTelemetryLabel->setVisible(true);
 }
 
 void GamepadForm::checkBytesWritten(int result)
@@ -225,11 +515,6 @@ void GamepadForm::setFontToPadButtons()
 	mUi->buttonPad2Right->setFont(font);
 }
 
-void GamepadForm::setButtonChecked(const int &key, bool checkStatus)
-{
-	controlButtonsHash[key]->setChecked(checkStatus);
-}
-
 void GamepadForm::createConnection()
 {
 	mMapperButtonPressed = new QSignalMapper(this);
@@ -248,7 +533,6 @@ void GamepadForm::createConnection()
 	connect(&connectionManager, SIGNAL(stateChanged(QAbstractSocket::SocketState)), this, SLOT(checkSocket(QAbstractSocket::SocketState)));
 	connect(&connectionManager, SIGNAL(dataWasWritten(int)), this, SLOT(checkBytesWritten(int)));
 	connect(&connectionManager, SIGNAL(connectionFailed()), this, SLOT(showConnectionFailedMessage()));
-	connect(this, SIGNAL(commandReceived(QString)), &connectionManager, SLOT(write(QString)));
 	connect(this, SIGNAL(programFinished()), &connectionManager, SLOT(disconnectFromHost()));
 
 	connect(strategy, SIGNAL(commandPrepared(QString)), this, SLOT(sendCommand(QString)));
@@ -257,13 +541,11 @@ void GamepadForm::createConnection()
 
 void GamepadForm::createMenu()
 {
-	// Path to your local directory. Set up if you don't put .qm files into your debug folder.
-	const QString pathToDir = "languages/trikDesktopGamepad";
-
-	const QString russian = pathToDir + "_ru";
-	const QString english = pathToDir + "_en";
-	const QString french = pathToDir + "_fr";
-	const QString german = pathToDir + "_de";
+	// Catalogs are compiled into resources, see trikDesktopGamepad.pro
+	const QString russian = "ru";
+	const QString english = "en";
+	const QString french = "fr";
+	const QString german = "de";
 
 	mMenuBar = new QMenuBar(this);
 
@@ -280,6 +562,25 @@ void GamepadForm::createMenu()
 	mTakeImageAction->setEnabled(false);
 	mTakeImageAction->setShortcut(QKeySequence("Ctrl+I"));
 	connect(mTakeImageAction, SIGNAL(triggered(bool)), this, SLOT(requestImage()));
+	mSaveFramesAction = new QAction(this);
+	mImageMenu->addAction(mSaveFramesAction);
+	mSaveFramesAction->setEnabled(false);
+	mSaveFramesAction->setShortcut(QKeySequence("Ctrl+Shift+I"));
+	connect(mSaveFramesAction, SIGNAL(triggered(bool)), this, SLOT(saveRecentFrames()));
+	mVideoMetricsAction = new QAction(this);
+	mImageMenu->addAction(mVideoMetricsAction);
+	mVideoMetricsAction->setCheckable(true);
+	connect(mVideoMetricsAction, SIGNAL(toggled(bool)), this, SLOT(setVideoMetricsVisible(bool)));
+	mPlotAction = new QAction(this);
+	mImageMenu->addAction(mPlotAction);
+	mPlotAction->setCheckable(true);
+	mPlotAction->setShortcut(QKeySequence("Ctrl+Shift+P"));
+	connect(mPlotAction, SIGNAL(toggled(bool)), this, SLOT(setPlotVisible(bool)));
+	mSnapshotModeAction = new QAction(this);
+	mImageMenu->addAction(mSnapshotModeAction);
+	mSnapshotModeAction->setCheckable(true);
+	mSnapshotModeAction->setChecked(QSettings().value("video/snapshotMode", false).toBool());
+	connect(mSnapshotModeAction, SIGNAL(toggled(bool)), this, SLOT(setSnapshotMode(bool)));
 
 	mLanguageMenu = new QMenu(this);
 	mMenuBar->addMenu(mLanguageMenu);
@@ -289,6 +590,11 @@ void GamepadForm::createMenu()
 	mConnectAction->setShortcuts(QKeySequence::New);
 	connect(mConnectAction, &QAction::triggered, this, &GamepadForm::openConnectDialog);
 
+	mDumpTraceAction = new QAction(this);
+	mDumpTraceAction->setShortcut(QKeySequence("Ctrl+Shift+T"));
+	mDumpTraceAction->setVisible(false);
+	connect(mDumpTraceAction, &QAction::triggered, this, &GamepadForm::dumpTrace);
+
 	mExitAction = new QAction(this);
 	mExitAction->setShortcuts(QKeySequence::Quit);
 	connect(mExitAction, &QAction::triggered, this, &GamepadForm::exit);
@@ -305,6 +611,11 @@ void GamepadForm::createMenu()
 	mModesActions->addAction(mAccelerateStrategyAction);
 	mModesActions->setExclusive(true);
 
+	mStreamingAction = new QAction(this);
+	mStreamingAction->setCheckable(true);
+	mStreamingAction->setChecked(QSettings().value("connection/streaming", false).toBool());
+	connect(mStreamingAction, SIGNAL(toggled(bool)), this, SLOT(setStreaming(bool)));
+
 	mRussianLanguageAction = new QAction(this);
 	mEnglishLanguageAction = new QAction(this);
 	mFrenchLanguageAction = new QAction(this);
@@ -330,14 +641,29 @@ void GamepadForm::createMenu()
 	connect(mFrenchLanguageAction, &QAction::triggered, this, [this, french](){changeLanguage(french);});
 	connect(mGermanLanguageAction, &QAction::triggered, this, [this, german](){changeLanguage(german);});
 
+	// interface is in English by default, catalog of system language is taken if there is one
+	const QMap<QString, QAction *> languageActions = {
+		{russian, mRussianLanguageAction}
+		, {french, mFrenchLanguageAction}
+		, {german, mGermanLanguageAction}
+	};
+	const QString systemLanguage = QLocale::system().name().left(2);
+	if (languageActions.contains(systemLanguage)) {
+		languageActions.value(systemLanguage)->setChecked(true);
+		changeLanguage(systemLanguage);
+	}
+
 	mAboutAction = new QAction(this);
 	connect(mAboutAction, &QAction::triggered, this, &GamepadForm::about);
 
 	mConnectionMenu->addAction(mConnectAction);
+	mConnectionMenu->addAction(mDumpTraceAction);
 	mConnectionMenu->addAction(mExitAction);
 
 	mModeMenu->addAction(mStandartStrategyAction);
 	mModeMenu->addAction(mAccelerateStrategyAction);
+	mModeMenu->addSeparator();
+	mModeMenu->addAction(mStreamingAction);
 
 	mLanguageMenu->addAction(mRussianLanguageAction);
 	mLanguageMenu->addAction(mEnglishLanguageAction);
@@ -379,6 +705,9 @@ void GamepadForm::setUpControlButtonsHash()
 	controlButtonsHash.insert(Qt::Key_Right, mUi->buttonPad2Right);
 	controlButtonsHash.insert(Qt::Key_Up, mUi->buttonPad2Up);
 	controlButtonsHash.insert(Qt::Key_Down, mUi->buttonPad2Down);
+
+	for (auto key : controlButtonsHash.keys())
+		mInputDispatcher.addButton(key, controlButtonsHash.value(key));
 }
 
 void GamepadForm::setLabels()
@@ -387,56 +716,97 @@ void GamepadForm::setLabels()
 	mUi->disconnectedLabel->setPixmap(redBall);
 	mUi->disconnectedLabel->setVisible(true);
 
+	// other states are shown only after connecting, so their images are loaded then
+	mUi->connectedLabel->setVisible(false);
+	mUi->connectingLabel->setVisible(false);
+}
+
+void GamepadForm::loadStatusPixmaps()
+{
+	if (mAreStatusPixmapsLoaded) {
+		return;
+	}
+
+	mAreStatusPixmapsLoaded = true;
 	QPixmap greenBall(":/images/greenBall.png");
 	mUi->connectedLabel->setPixmap(greenBall);
-	mUi->connectedLabel->setVisible(false);
 
 	QPixmap blueBall(":/images/blueBall.png");
 	mUi->connectingLabel->setPixmap(blueBall);
-	mUi->connectingLabel->setVisible(false);
 }
 
 void GamepadForm::setImageControl()
 {
-	probe = new QVideoProbe(this);
-	connect(probe, SIGNAL(videoFrameProbed(QVideoFrame)), this, SLOT(saveImageToClipboard(QVideoFrame)), Qt::QueuedConnection);
-	isFrameNecessary = false;
-	probe->setSource(player);
 	clipboard = QApplication::clipboard();
-}
-
-bool GamepadForm::eventFilter(QObject *obj, QEvent *event)
-{
-	Q_UNUSED(obj)
-
-	// Handle key press event for View
-	if(event->type() == QEvent::KeyPress) {
-		int pressedKey = (dynamic_cast<QKeyEvent *> (event))->key();
-		if (controlButtonsHash.keys().contains(pressedKey))
-			setButtonChecked(pressedKey, true);
-
-	} else if(event->type() == QEvent::KeyRelease) {
 
-		QKeyEvent *keyEvent = dynamic_cast<QKeyEvent*>(event);
-
-		auto releasedKey = keyEvent->key();
-		if (controlButtonsHash.keys().contains(releasedKey))
-			setButtonChecked(releasedKey, false);
+	QSettings settings;
+	settings.beginGroup("snapshots");
+	mFrameRing.setWindow(settings.value("preTriggerSeconds", 5).toLongLong() * 1000);
+	mFrameRing.setByteBudget(settings.value("byteBudgetMb", 64).toLongLong() * 1024 * 1024);
+	mBurstFrames = settings.value("burstFrames", 30).toInt();
+
+	mSnapshotExporter = new SnapshotExporter(this);
+	mSnapshotExporter->setDirectory(settings.value("directory", QDir::currentPath()).toString());
+	const bool isPng = settings.value("format", "jpg").toString() == "png";
+	mSnapshotExporter->setFormat(isPng ? SnapshotExporter::Format::png : SnapshotExporter::Format::jpeg);
+	connect(mSnapshotExporter, SIGNAL(exportFinished(QString, int, int)), this, SLOT(handleFramesSaved(QString, int, int)));
+	settings.endGroup();
+}
+
+void GamepadForm::setUpMetrics()
+{
+	QSettings settings;
+	settings.beginGroup("metrics");
+	const quint16 port = static_cast<quint16>(settings.value("port", 0).toUInt());
+	const QString address = settings.value("address", "127.0.0.1").toString();
+	const QString socketPath = settings.value("socket").toString();
+	settings.endGroup();
+	if (port == 0 && socketPath.isEmpty()) {
+		return;
 	}
 
-	// delegating events to Command-generating-strategy
-	strategy->processEvent(event);
+	mMetricsThread.setObjectName("metrics");
+	mMetricsServer.moveToThread(&mMetricsThread);
+	connect(&mMetricsServer, &MetricsServer::failed, this, [](const QString &errorString) {
+		qWarning("Metrics server failed: %s", qPrintable(errorString));
+	});
+	mMetricsThread.start(QThread::LowPriority);
+	if (port != 0) {
+		QMetaObject::invokeMethod(&mMetricsServer, "listen", Qt::QueuedConnection
+				, Q_ARG(QString, address), Q_ARG(quint16, port));
+	}
 
-	return false;
+	if (!socketPath.isEmpty()) {
+		QMetaObject::invokeMethod(&mMetricsServer, "listenLocal", Qt::QueuedConnection, Q_ARG(QString, socketPath));
+	}
 }
 
 void GamepadForm::sendCommand(const QString &command)
 {
-	if (!connectionManager.isConnected()) {
-		return;
+	TraceSpan span("commandPrepared");
+	// state of keys is tracked without connection too, it is resent as soon as robot is connected
+	connectionManager.send(command);
+
+	if (mPlotPanel->isVisible()) {
+		const GamepadCommand parsed = GamepadCommand::parse(command.trimmed().toLatin1());
+		const qint64 now = TelemetryReader::timestamp();
+		if (parsed.type == GamepadCommand::Type::pad || parsed.type == GamepadCommand::Type::padUp) {
+			// released pad is back at the center
+			const QByteArray pad = "pad" + QByteArray::number(parsed.id);
+			mPlotPanel->addSample(pad + " x", parsed.x, now);
+			mPlotPanel->addSample(pad + " y", parsed.y, now);
+		} else if (parsed.type == GamepadCommand::Type::wheel) {
+			mPlotPanel->addSample("wheel", parsed.x, now);
+		}
 	}
+}
 
-	emit commandReceived(command);
+void GamepadForm::setStreaming(bool isStreaming)
+{
+	QSettings settings;
+	settings.setValue("connection/streaming", isStreaming);
+	const int rate = isStreaming ? qBound(1, settings.value("connection/streamRateHz", 50).toInt(), 1000) : 0;
+	QMetaObject::invokeMethod(&connectionManager, "setStreamingRate", Qt::QueuedConnection, Q_ARG(int, rate));
 }
 
 void GamepadForm::changeMode(Strategies type)
@@ -444,67 +814,54 @@ void GamepadForm::changeMode(Strategies type)
 	disconnect(strategy, SIGNAL(commandPrepared(QString)), this, SLOT(sendCommand(QString)));
 	strategy = Strategy::getStrategy(type);
 	connect(strategy, SIGNAL(commandPrepared(QString)), this, SLOT(sendCommand(QString)));
+	mInputDispatcher.setStrategy(strategy);
 }
 
 void GamepadForm::dealWithApplicationState(Qt::ApplicationState state)
 {
 	if (state != Qt::ApplicationActive) {
 		strategy->reset();
-		for (auto button : controlButtonsHash.values())
-			button->setChecked(false);
+		mInputDispatcher.releaseAll();
 	}
 }
 
-void GamepadForm::saveImageToClipboard(QVideoFrame buffer)
+void GamepadForm::requestImage()
 {
-	if (isFrameNecessary) {
-		isFrameNecessary = false;
-		QVideoFrame frame(buffer);
-		frame.map(QAbstractVideoBuffer::ReadOnly);
+	QImage image;
+	if (image.loadFromData(mLastFrame, "JPG")) {
+		clipboard->setImage(image);
+	}
+}
 
-		QImage::Format imageFormat = QVideoFrame::imageFormatFromPixelFormat(frame.pixelFormat());
-		QImage img;
-		// check whether videoframe can be transformed to qimage by qt
-		if (imageFormat != QImage::Format_Invalid) {
-			img = QImage(frame.bits(),
-						 frame.width(),
-						 frame.height(),
-						 // frame.bytesPerLine(),
-						 imageFormat);
-		} else {
-			int width = frame.width();
-			int height = frame.height();
-			int size = height * width;
-			const uchar *data = frame.bits();
-
-			img = QImage(width, height, QImage::Format_RGB32);
-			/// converting from yuv420 to rgb32
-			for (int i = 0; i < height; i++)
-				for (int j = 0; j < width; j++) {
-					int y = static_cast<int> (data[i * width + j]);
-					int u = static_cast<int> (data[(i / 2) * (width / 2) + (j / 2) + size]);
-					int v = static_cast<int> (data[(i / 2) * (width / 2) + (j / 2) + size + (size / 4)]);
-
-					int r = y + int(1.13983 * (v - 128));
-					int g = y - int(0.39465 * (u - 128)) - int(0.58060 * (v - 128));
-					int b = y + int(2.03211 * (u - 128));
-
-					r = r < 0 ? 0 : r > 255 ? 255 : r;
-					g = g < 0 ? 0 : g > 255 ? 255 : g;
-					b = b < 0 ? 0 : b > 255 ? 255 : b;
-
-					img.setPixel(j, i, qRgb(r, g, b));
-				}
-		}
+void GamepadForm::saveRecentFrames()
+{
+	if (!mSnapshotExporter->beginSession()) {
+		QMessageBox::warning(this, tr("Saving frames"), tr("Couldn't create directory for frames"));
+		return;
+	}
 
-		clipboard->setImage(img);
-		frame.unmap();
+	mSnapshotExporter->exportFrames(mFrameRing.frames());
+	mBurstFramesLeft = mBurstFrames;
+	if (mBurstFramesLeft == 0) {
+		mSnapshotExporter->finishSession();
 	}
 }
 
-void GamepadForm::requestImage()
+void GamepadForm::handleFramesSaved(const QString &directory, int savedFrames, int failedFrames)
+{
+	if (failedFrames > 0) {
+		QMessageBox::warning(this, tr("Saving frames")
+				, tr("%1 of %2 frames couldn't be saved to %3")
+						.arg(failedFrames).arg(savedFrames + failedFrames).arg(directory));
+	}
+}
+
+void GamepadForm::dumpTrace()
 {
-	isFrameNecessary = true;
+	QString errorString;
+	if (!Tracer::dump(mTraceFile, errorString)) {
+		QMessageBox::warning(this, tr("Trace"), tr("Couldn't write trace to %1: %2").arg(mTraceFile, errorString));
+	}
 }
 
 void GamepadForm::openConnectDialog()
@@ -538,25 +895,29 @@ void GamepadForm::changeEvent(QEvent *event)
 		retranslate();
 	}
 
+	if (event->type() == QEvent::ActivationChange && !isActiveWindow()) {
+		// releases of keys go to the other window, so keys are not considered held when the form is back
+		strategy->reset();
+		mInputDispatcher.releaseAll();
+	}
+
 	QWidget::changeEvent(event);
 }
 
 void GamepadForm::handleButtonPress(QWidget *widget)
 {
 	QPushButton *padButton = dynamic_cast<QPushButton *> (widget);
-	padButton->setChecked(true);
 	auto key = controlButtonsHash.key(padButton);
 	QKeyEvent keyEvent(QEvent::KeyPress, key, Qt::NoModifier);
-	strategy->processEvent(&keyEvent);
+	mInputDispatcher.dispatch(&keyEvent);
 }
 
 void GamepadForm::handleButtonRelease(QWidget *widget)
 {
 	QPushButton *padButton = dynamic_cast<QPushButton *> (widget);
-	padButton->setChecked(false);
 	auto key = controlButtonsHash.key(padButton);
 	QKeyEvent keyEvent(QEvent::KeyRelease, key, Qt::NoModifier);
-	strategy->processEvent(&keyEvent);
+	mInputDispatcher.dispatch(&keyEvent);
 }
 
 void GamepadForm::retranslate()
@@ -566,10 +927,12 @@ void GamepadForm::retranslate()
 	mLanguageMenu->setTitle(tr("&Language"));
 
 	mConnectAction->setText(tr("&Connect"));
+	mDumpTraceAction->setText(tr("Dump &trace"));
 	mExitAction->setText(tr("&Exit"));
 
 	mStandartStrategyAction->setText(tr("&Simple"));
 	mAccelerateStrategyAction->setText(tr("&Accelerate"));
+	mStreamingAction->setText(tr("&Fixed-rate sending"));
 
 	mRussianLanguageAction->setText(tr("&Russian"));
 	mEnglishLanguageAction->setText(tr("&English"));
@@ -578,6 +941,10 @@ void GamepadForm::retranslate()
 
 	mImageMenu->setTitle(tr("&Image"));
 	mTakeImageAction->setText(tr("&Screenshot to clipboard"));
+	mSaveFramesAction->setText(tr("Save &recent frames"));
+	mVideoMetricsAction->setText(tr("Video &statistics"));
+	mPlotAction->setText(tr("Telemetry &plots"));
+	mSnapshotModeAction->setText(tr("Poll s&napshots"));
 
 	mAboutAction->setText(tr("&About"));
 
@@ -585,11 +952,29 @@ void GamepadForm::retranslate()
 
 void GamepadForm::changeLanguage(const QString &language)
 {
-	mTranslator = new QTranslator(this);
-	mTranslator->load(language);
-	qApp->installTranslator(mTranslator);
+	QTranslator *translator = mTranslators.value(language);
+	if (!translator) {
+		// catalog is loaded only when language is chosen for the first time, it is not copied from resources
+		translator = new QTranslator(this);
+		if (!translator->load(":/languages/trikDesktopGamepad_" + language)) {
+			delete translator;
+			return;
+		}
+
+		mTranslators.insert(language, translator);
+	}
+
+	if (mTranslator == translator) {
+		return;
+	}
 
-	mUi->retranslateUi(this);
+	if (mTranslator) {
+		qApp->removeTranslator(mTranslator);
+	}
+
+	mTranslator = translator;
+	// installing translator posts LanguageChange event, so widgets are retranslated once in changeEvent()
+	qApp->installTranslator(mTranslator);
 }
 
 void GamepadForm::about()
@@ -17,9 +17,6 @@
 
 #pragma once
 
-#include <QMediaPlayer>
-#include <QVideoWidget>
-
 #include <QtWidgets/QWidget>
 #include <QtWidgets/QMenuBar>
 #include <QtNetwork/QTcpSocket>
@@ -27,16 +24,27 @@
 #include <QtCore/QTranslator>
 #include <QtCore/QSignalMapper>
 #include <QtWidgets/QShortcut>
+#include <QtWidgets/QLabel>
 #include <QMovie>
 #include <QThread>
 
-#include <QVideoProbe>
 #include <QClipboard>
 
 #include "connectForm.h"
 
 #include "connectionManager.h"
 #include "strategy.h"
+#include "mjpegStreamReader.h"
+#include "videoDecoder.h"
+#include "frameView.h"
+#include "frameRingBuffer.h"
+#include "snapshotExporter.h"
+#include "videoWatchdog.h"
+#include "sharedFramePublisher.h"
+#include "inputDispatcher.h"
+#include "metricsServer.h"
+#include "plotPanel.h"
+#include "automationServer.h"
 
 namespace Ui {
 class GamepadForm;
@@ -57,6 +65,15 @@ public:
 	~GamepadForm() override;
 	void startController(QStringList args);
 
+	/// file that trace is dumped to by menu action, action is shown only if tracing is on
+	void setTraceFile(const QString &fileName);
+
+	/// commands sent to robot are written to journal, it should live longer than the form
+	void setJournal(CommandJournal *journal);
+
+	/// takes commands from other programs through local socket, see AutomationServer
+	bool listenAutomation(const QString &path, QString &errorString);
+
 public slots:
 
 	/// Slot for opening connect dialog
@@ -76,9 +93,6 @@ private slots:
 	/// Slots for pad buttons (Up, Down, Left, Right) and "magic" buttons, triggered when button is released.
 	void handleButtonRelease(QWidget*);
 
-	/// Slot for handle key pressing and releasing events
-	bool eventFilter(QObject *obj, QEvent *event) override;
-
 	/// Slot for creating menu bar
 	void createMenu();
 
@@ -94,14 +108,51 @@ private slots:
 	/// Helper method for setting Video Widget
 	void setVideoController();
 
-	void handleMediaStatusChanged(QMediaPlayer::MediaStatus status);
+	/// creates stream reader and view of video, is called when camera is configured for the first time
+	void createVideoPipeline();
 
 	void startVideoStream();
 
+	/// reopens camera stream that stopped delivering frames, connection to robot is not touched
+	void reconnectVideoStream();
+
+	/// slots for tracking state of camera stream
+	void handleStreamStarted();
+	void handleStreamFailed();
+	void handleStreamFinished();
+
+	/// slot for compressed frame from camera, frame is buffered and passed to decoder
+	void handleFrameReceived(const QByteArray &jpeg, quint64 sequence, qint64 timestamp);
+
+	/// slot for frame that was decoded by decoding pool
+	void showFrame(const QImage &image, quint64 sequence);
+
+	/// shows or hides statistics of video path
+	void setVideoMetricsVisible(bool isVisible);
+	void updateVideoMetrics();
+
+	/// shows or hides plots, they start empty every time they are shown
+	void setPlotVisible(bool isVisible);
+
+	/// switches camera between MJPEG stream and polling of single snapshots, choice is kept in settings
+	void setSnapshotMode(bool isSnapshotMode);
+
+	/// writes timeline of input, commands and video to trace file
+	void dumpTrace();
+
 	void checkSocket(QAbstractSocket::SocketState state);
 
 	void startThread();
 
+	/// reports that connection thread released pads because this thread stopped heartbeats
+	void showPadsReleased(qint64 silenceMs);
+
+	/// reports how fast held keys were resent to robot after connection
+	void showStateResynced(int commands, qint64 recoveryUs);
+
+	/// shows the latest values of telemetry that robot sends back
+	void showTelemetry(const QVector<TelemetrySample> &samples);
+
 	void checkBytesWritten(int result);
 
 	void showConnectionFailedMessage();
@@ -114,26 +165,46 @@ private slots:
 	/// slot is invoked when user presses mode actions
 	void changeMode(Strategies type);
 
+	/// turns sending of gamepad state at fixed rate by connection thread on or off
+	void setStreaming(bool isStreaming);
+
 	/// handling application state
 	void dealWithApplicationState(Qt::ApplicationState state);
 
-	void saveImageToClipboard(QVideoFrame buffer);
 	void requestImage();
 
+	/// saves frames from pre-trigger buffer and a burst of following frames to files
+	void saveRecentFrames();
+	void handleFramesSaved(const QString &directory, int savedFrames, int failedFrames);
+
 signals:
-	void commandReceived(QString);
 	void programFinished();
 	void dataReceivedFromCommandLine();
 
 private:
-	void setButtonChecked(const int &key, bool checkStatus);
+	enum class VideoState {
+		noVideo
+		, loading
+		, playing
+		, invalid
+	};
+
+	void setVideoState(VideoState state);
+
+	/// ends saving of frames after "save recent frames" when stream is gone
+	void finishBurst();
+
 	/// Helper method that enables or disables gamepad buttons depending on connection state.
 	void setButtonsEnabled(bool enabled);
 	void setButtonsCheckable(bool checkableStatus);
 	void setUpControlButtonsHash();
 	void setLabels();
+	void loadStatusPixmaps();
 	void setImageControl();
 
+	/// starts metrics server if it is turned on in settings
+	void setUpMetrics();
+
 	/// Field with GUI automatically generated by gamepadForm.ui.
 	Ui::GamepadForm *mUi;
 
@@ -152,6 +223,7 @@ private:
 
 	/// Menu actions
 	QAction *mConnectAction;
+	QAction *mDumpTraceAction;
 	QAction *mExitAction;
 	QAction *mAboutAction;
 
@@ -165,22 +237,34 @@ private:
 
 	/// Image Actions
 	QAction *mTakeImageAction;
+	QAction *mSaveFramesAction;
+	QAction *mVideoMetricsAction;
+	QAction *mPlotAction;
+	QAction *mSnapshotModeAction;
 
 	/// Mode actions
 	QAction *mStandartStrategyAction;
 	QAction *mAccelerateStrategyAction;
+	QAction *mStreamingAction;
 
 	QActionGroup *mModesActions;
 
-	/// For setting up translator in app
+	/// For setting up translator in app, is one of mTranslators or nullptr if no catalog was chosen
 	QTranslator *mTranslator;
 
+	/// Translators for languages that were chosen at least once
+	QHash<QString, QTranslator *> mTranslators;
+
 	/// object that encapsulates logic with commands
 	Strategy *strategy;
 
+	bool mAreStatusPixmapsLoaded;
 
 	QHash<int, QPushButton*> controlButtonsHash;
 
+	/// passes key events to strategy and highlights buttons
+	InputDispatcher mInputDispatcher;
+
 	QShortcut *shortcut;
 	/// For changing language whem another language was chosen
 	void retranslate();
@@ -194,11 +278,50 @@ private:
 	/// Class that handles network communication with TRIK.
 	ConnectionManager connectionManager;
 	QThread thread;
-	QMediaPlayer *player;
-	QVideoWidget *videoWidget;
+
+	/// Video from robot camera, frames are received here and decoded on a pool of threads.
+	MjpegStreamReader *mStreamReader;
+	VideoDecoder mVideoDecoder;
+	VideoWatchdog mVideoWatchdog;
+	FrameView *mFrameView;
 	QMovie movie;
 
+	/// exports decoded frames to other processes, is opened only if it is turned on in settings
+	SharedFramePublisher mSharedFramePublisher;
+
+	QLabel *mTelemetryLabel;
+
+	/// plots of telemetry and of pad values that are sent
+	PlotPanel *mPlotPanel;
+
+	/// the latest value of every telemetry key
+	QMap<QByteArray, double> mTelemetry;
+
+	QLabel *mVideoMetricsLabel;
+	QTimer mVideoMetricsTimer;
+	VideoMetrics mVideoMetrics;
+
 	QClipboard *clipboard;
-	QVideoProbe *probe;
-	bool isFrameNecessary;
+
+	/// the latest received frame, is used for screenshots in full resolution
+	QByteArray mLastFrame;
+
+	/// frames received during last seconds, are saved when user asks for it
+	FrameRingBuffer mFrameRing;
+	SnapshotExporter *mSnapshotExporter;
+
+	/// number of frames that are saved after the moment user asked for it
+	int mBurstFrames;
+	int mBurstFramesLeft;
+
+	QString mTraceFile;
+
+	/// keeps DeadManWatchdog of connection thread from releasing pads while this thread is alive
+	QTimer mHeartbeatTimer;
+
+	/// serves counters of gamepad to Prometheus from its own thread
+	MetricsServer mMetricsServer;
+	QThread mMetricsThread;
+
+	AutomationServer mAutomationServer;
 };
@@ -0,0 +1,80 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "gamepadState.h"
+
+#include "commandProtocol.h"
+
+bool GamepadState::apply(const GamepadCommand &command)
+{
+	switch (command.type) {
+	case GamepadCommand::Type::pad:
+		pads[command.id - 1].isHeld = true;
+		pads[command.id - 1].x = command.x;
+		pads[command.id - 1].y = command.y;
+		return true;
+	case GamepadCommand::Type::padUp:
+		pads[command.id - 1].isHeld = false;
+		return true;
+	case GamepadCommand::Type::button:
+		buttonPresses.append(command.id);
+		return true;
+	case GamepadCommand::Type::wheel:
+		wheel = command.x;
+		return true;
+	case GamepadCommand::Type::invalid:
+		break;
+	}
+
+	return false;
+}
+
+QList<QByteArray> GamepadState::changesSince(const GamepadState &from) const
+{
+	QList<QByteArray> result;
+	for (int i = 0; i < padsCount; ++i) {
+		GamepadCommand command;
+		command.id = i + 1;
+		if (pads[i].isHeld && (!from.pads[i].isHeld || pads[i].x != from.pads[i].x || pads[i].y != from.pads[i].y)) {
+			command.type = GamepadCommand::Type::pad;
+			command.x = pads[i].x;
+			command.y = pads[i].y;
+		} else if (!pads[i].isHeld && from.pads[i].isHeld) {
+			command.type = GamepadCommand::Type::padUp;
+		}
+
+		if (command.isValid()) {
+			result.append(command.toLine());
+		}
+	}
+
+	if (wheel != from.wheel) {
+		GamepadCommand command;
+		command.type = GamepadCommand::Type::wheel;
+		command.x = wheel;
+		result.append(command.toLine());
+	}
+
+	for (const int button : buttonPresses) {
+		GamepadCommand command;
+		command.type = GamepadCommand::Type::button;
+		command.id = button;
+		result.append(command.toLine());
+	}
+
+	return result;
+}
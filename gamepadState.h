@@ -0,0 +1,51 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+
+struct GamepadCommand;
+
+/// What gamepad has told robot to do: positions of pads and wheel, and button presses that are not sent yet.
+/// Commands change it, and difference of two states gives commands that turn one into another, so state can be
+/// sent at a fixed rate or replayed after reconnection.
+struct GamepadState
+{
+	static const int padsCount = 2;
+
+	struct Pad
+	{
+		bool isHeld = false;
+		int x = 0;
+		int y = 0;
+	};
+
+	Pad pads[padsCount];
+	int wheel = 0;
+
+	/// buttons are events rather than state, so every press is kept until it is taken
+	QVector<int> buttonPresses;
+
+	/// returns false for commands that are not part of state
+	bool apply(const GamepadCommand &command);
+
+	/// commands that turn robot from state "from" to this one, including all button presses
+	QList<QByteArray> changesSince(const GamepadState &from) const;
+};
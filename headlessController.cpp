@@ -0,0 +1,413 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "headlessController.h"
+
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QKeyEvent>
+#include <QFile>
+#include <QTextStream>
+#include <QSettings>
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <linux/input.h>
+#endif
+
+namespace {
+/// how long key is held by "tap" command if duration is not given
+const int defaultTapDuration = 100;
+
+#ifdef Q_OS_LINUX
+int keyFromDeviceCode(int code)
+{
+	switch (code) {
+	case KEY_W: return Qt::Key_W;
+	case KEY_A: return Qt::Key_A;
+	case KEY_S: return Qt::Key_S;
+	case KEY_D: return Qt::Key_D;
+	case KEY_UP: return Qt::Key_Up;
+	case KEY_DOWN: return Qt::Key_Down;
+	case KEY_LEFT: return Qt::Key_Left;
+	case KEY_RIGHT: return Qt::Key_Right;
+	case KEY_1: return Qt::Key_1;
+	case KEY_2: return Qt::Key_2;
+	case KEY_3: return Qt::Key_3;
+	case KEY_4: return Qt::Key_4;
+	case KEY_5: return Qt::Key_5;
+	default: return 0;
+	}
+}
+#endif
+}
+
+HeadlessController::HeadlessController()
+	: strategy(Strategy::getStrategy(standartStrategy))
+	, mIsConnected(false)
+	, mIsInputFinished(false)
+	, mInputNotifier(nullptr)
+	, mDeviceFd(-1)
+	, mDeviceNotifier(nullptr)
+{
+	mKeyNames = {
+		{"w", Qt::Key_W}
+		, {"a", Qt::Key_A}
+		, {"s", Qt::Key_S}
+		, {"d", Qt::Key_D}
+		, {"up", Qt::Key_Up}
+		, {"down", Qt::Key_Down}
+		, {"left", Qt::Key_Left}
+		, {"right", Qt::Key_Right}
+		, {"1", Qt::Key_1}
+		, {"2", Qt::Key_2}
+		, {"3", Qt::Key_3}
+		, {"4", Qt::Key_4}
+		, {"5", Qt::Key_5}
+	};
+
+	mWaitTimer.setSingleShot(true);
+	mWaitTimer.setTimerType(Qt::PreciseTimer);
+	connect(&mWaitTimer, SIGNAL(timeout()), this, SLOT(executeCommands()));
+	connect(strategy, SIGNAL(commandPrepared(QString)), this, SLOT(sendCommand(QString)));
+
+	QSettings settings;
+	connectionManager.setDeadManTimeout(settings.value("safety/deadManTimeoutMs", 500).toInt());
+	connect(&connectionManager, SIGNAL(padsReleased(qint64)), this, SLOT(handlePadsReleased(qint64)));
+	connect(&mHeartbeatTimer, &QTimer::timeout, this, [this]() {
+		connectionManager.heartbeat();
+	});
+	if (connectionManager.heartbeatInterval() > 0) {
+		mHeartbeatTimer.start(connectionManager.heartbeatInterval());
+	}
+
+	thread.setObjectName("connection");
+	connectionManager.moveToThread(&thread);
+	thread.start();
+	if (settings.value("connection/streaming", false).toBool()) {
+		const int rate = qBound(1, settings.value("connection/streamRateHz", 50).toInt(), 1000);
+		QMetaObject::invokeMethod(&connectionManager, "setStreamingRate", Qt::QueuedConnection, Q_ARG(int, rate));
+	}
+
+	connect(&connectionManager, SIGNAL(stateChanged(QAbstractSocket::SocketState))
+			, this, SLOT(checkSocket(QAbstractSocket::SocketState)));
+	connect(&connectionManager, SIGNAL(connectionFailed()), this, SLOT(handleConnectionFailed()));
+	connect(this, SIGNAL(connectionRequested()), &connectionManager, SLOT(connectToHost()));
+	connect(this, SIGNAL(programFinished()), &connectionManager, SLOT(disconnectFromHost()));
+}
+
+HeadlessController::~HeadlessController()
+{
+	// disabling socket from thread where it was enabled
+	emit programFinished();
+	thread.quit();
+	thread.wait();
+
+#ifdef Q_OS_UNIX
+	if (mDeviceFd != -1) {
+		::close(mDeviceFd);
+	}
+#endif
+}
+
+void HeadlessController::startController(const QStringList &args)
+{
+	connectionManager.setGamepadIp(args.at(1));
+	const QString portStr = args.size() < 3 ? "4444" : args.at(2);
+	connectionManager.setGamepadPort(static_cast<quint16>(portStr.toInt()));
+	emit connectionRequested();
+}
+
+bool HeadlessController::runScript(const QString &fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		mErrorString = tr("Can not open script %1: %2").arg(fileName, file.errorString());
+		return false;
+	}
+
+	QTextStream stream(&file);
+	while (!stream.atEnd()) {
+		appendCommand(stream.readLine());
+	}
+
+	finishInput();
+	return true;
+}
+
+bool HeadlessController::readStandardInput()
+{
+#ifdef Q_OS_UNIX
+	mInputNotifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+	connect(mInputNotifier, SIGNAL(activated(int)), this, SLOT(readStandardInputLines()));
+	return true;
+#else
+	mErrorString = tr("Reading commands from standard input is not supported on this platform, use script file");
+	return false;
+#endif
+}
+
+bool HeadlessController::readDevice(const QString &deviceName)
+{
+#ifdef Q_OS_LINUX
+	mDeviceFd = ::open(QFile::encodeName(deviceName).constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (mDeviceFd == -1) {
+		mErrorString = tr("Can not open input device %1: %2").arg(deviceName, QString::fromLocal8Bit(strerror(errno)));
+		return false;
+	}
+
+	mDeviceNotifier = new QSocketNotifier(mDeviceFd, QSocketNotifier::Read, this);
+	connect(mDeviceNotifier, SIGNAL(activated(int)), this, SLOT(readDeviceEvents()));
+	return true;
+#else
+	mErrorString = tr("Input devices can be read only on Linux, %1 is not opened").arg(deviceName);
+	return false;
+#endif
+}
+
+bool HeadlessController::listenAutomation(const QString &path)
+{
+	if (!mAutomationServer.listen(path)) {
+		mErrorString = tr("Can not listen automation socket %1: %2").arg(path, mAutomationServer.errorString());
+		return false;
+	}
+
+	connect(&mAutomationServer, SIGNAL(commandPrepared(QString)), this, SLOT(sendCommand(QString)));
+	mAutomationServer.setStatusProvider([this]() {
+		QJsonObject status;
+		status.insert("connected", mIsConnected);
+		status.insert("robot", connectionManager.getGamepadIp());
+		status.insert("port", connectionManager.getGamepadPort());
+		return status;
+	});
+	return true;
+}
+
+QString HeadlessController::errorString() const
+{
+	return mErrorString;
+}
+
+void HeadlessController::setJournal(CommandJournal *journal)
+{
+	connectionManager.setJournal(journal);
+}
+
+void HeadlessController::checkSocket(QAbstractSocket::SocketState state)
+{
+	if (state == QAbstractSocket::ConnectedState) {
+		mIsConnected = true;
+		executeCommands();
+	} else if (state == QAbstractSocket::UnconnectedState && mIsConnected) {
+		mIsConnected = false;
+		fprintf(stderr, "%s\n", qPrintable(tr("Connection to robot is lost")));
+		finish(1);
+	}
+}
+
+void HeadlessController::handleConnectionFailed()
+{
+	fprintf(stderr, "%s\n", qPrintable(tr("Could not connect to %1:%2")
+			.arg(connectionManager.getGamepadIp()).arg(connectionManager.getGamepadPort())));
+	finish(1);
+}
+
+void HeadlessController::handlePadsReleased(qint64 silenceMs)
+{
+	fprintf(stderr, "%s\n", qPrintable(tr("Pads were released by connection thread, input did not respond for %1 ms")
+			.arg(silenceMs)));
+}
+
+void HeadlessController::sendCommand(const QString &command)
+{
+	if (!mIsConnected) {
+		return;
+	}
+
+	connectionManager.send(command);
+}
+
+void HeadlessController::appendCommand(const QString &line)
+{
+	const QString command = line.section('#', 0, 0).trimmed();
+	if (command.isEmpty()) {
+		return;
+	}
+
+	mCommands.enqueue(command);
+	executeCommands();
+}
+
+void HeadlessController::finishInput()
+{
+	mIsInputFinished = true;
+	executeCommands();
+}
+
+void HeadlessController::executeCommands()
+{
+	// commands are kept until connection is established, so none of them is lost
+	if (!mIsConnected || mWaitTimer.isActive()) {
+		return;
+	}
+
+	while (!mCommands.isEmpty()) {
+		if (!execute(mCommands.dequeue())) {
+			return;
+		}
+	}
+
+	if (mIsInputFinished) {
+		finish(0);
+	}
+}
+
+void HeadlessController::readStandardInputLines()
+{
+#ifdef Q_OS_UNIX
+	char buffer[4096];
+	const ssize_t size = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+	if (size <= 0) {
+		mInputNotifier->setEnabled(false);
+		appendCommand(QString::fromLocal8Bit(mInputBuffer));
+		mInputBuffer.clear();
+		finishInput();
+		return;
+	}
+
+	mInputBuffer.append(buffer, static_cast<int>(size));
+	int lineEnd = mInputBuffer.indexOf('\n');
+	while (lineEnd != -1) {
+		const QByteArray line = mInputBuffer.left(lineEnd);
+		mInputBuffer.remove(0, lineEnd + 1);
+		appendCommand(QString::fromLocal8Bit(line));
+		lineEnd = mInputBuffer.indexOf('\n');
+	}
+#endif
+}
+
+void HeadlessController::readDeviceEvents()
+{
+#ifdef Q_OS_LINUX
+	input_event events[64];
+	ssize_t size = ::read(mDeviceFd, events, sizeof(events));
+	while (size > 0) {
+		const int count = static_cast<int>(size / static_cast<ssize_t>(sizeof(input_event)));
+		for (int i = 0; i < count; ++i) {
+			if (events[i].type != EV_KEY) {
+				continue;
+			}
+
+			const int key = keyFromDeviceCode(events[i].code);
+			if (key != 0) {
+				// value is 0 for release, 1 for press and 2 for autorepeat
+				setKeyState(key, events[i].value != 0, events[i].value == 2);
+			}
+		}
+
+		size = ::read(mDeviceFd, events, sizeof(events));
+	}
+
+	if (size == 0 || (size == -1 && errno != EAGAIN && errno != EINTR)) {
+		// device is unplugged
+		mDeviceNotifier->setEnabled(false);
+		fprintf(stderr, "%s\n", qPrintable(tr("Input device is closed")));
+		finish(1);
+	}
+#endif
+}
+
+bool HeadlessController::execute(const QString &line)
+{
+	const QStringList words = line.simplified().split(' ');
+	const QString &command = words.first();
+	const auto key = words.size() > 1 ? mKeyNames.constFind(words.at(1).toLower()) : mKeyNames.constEnd();
+
+	if ((command == "press" || command == "release") && key != mKeyNames.constEnd()) {
+		setKeyState(key.value(), command == "press");
+	} else if (command == "tap" && key != mKeyNames.constEnd()) {
+		const int duration = words.size() > 2 ? words.at(2).toInt() : defaultTapDuration;
+		setKeyState(key.value(), true);
+		mCommands.prepend("release " + words.at(1));
+		if (duration > 0) {
+			mCommands.prepend("wait " + QString::number(duration));
+		}
+	} else if (command == "wait" && words.size() > 1) {
+		mWaitTimer.start(words.at(1).toInt());
+		return false;
+	} else if (command == "mode" && words.size() > 1 && words.at(1) == "standard") {
+		changeMode(standartStrategy);
+	} else if (command == "mode" && words.size() > 1 && words.at(1) == "accelerate") {
+		changeMode(accelerateStrategy);
+	} else if (command == "quit") {
+		mCommands.clear();
+		mIsInputFinished = true;
+	} else {
+		fprintf(stderr, "%s\n", qPrintable(tr("Unknown command: %1").arg(line)));
+	}
+
+	return true;
+}
+
+void HeadlessController::setKeyState(int key, bool isPressed, bool isAutoRepeat)
+{
+	if (isPressed) {
+		mPressedKeys += key;
+	} else {
+		mPressedKeys -= key;
+	}
+
+	QKeyEvent event(isPressed ? QEvent::KeyPress : QEvent::KeyRelease, key, Qt::NoModifier
+			, QString(), isAutoRepeat);
+	strategy->processEvent(&event);
+}
+
+void HeadlessController::releaseAllKeys()
+{
+	const QSet<int> keys = mPressedKeys;
+	for (const int key : keys) {
+		setKeyState(key, false);
+	}
+}
+
+void HeadlessController::changeMode(Strategies type)
+{
+	releaseAllKeys();
+	disconnect(strategy, SIGNAL(commandPrepared(QString)), this, SLOT(sendCommand(QString)));
+	strategy = Strategy::getStrategy(type);
+	connect(strategy, SIGNAL(commandPrepared(QString)), this, SLOT(sendCommand(QString)));
+}
+
+void HeadlessController::finish(int exitCode)
+{
+	mCommands.clear();
+	mWaitTimer.stop();
+	releaseAllKeys();
+	// disconnection that follows is not a loss of connection
+	mIsConnected = false;
+	// commands are written in connection thread before disconnection, as they are queued in the same order
+	emit programFinished();
+	QCoreApplication::exit(exitCode);
+}
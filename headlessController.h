@@ -0,0 +1,115 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QQueue>
+#include <QSet>
+#include <QHash>
+
+#include "connectionManager.h"
+#include "strategy.h"
+#include "automationServer.h"
+
+class QSocketNotifier;
+
+/// Controls robot without any GUI: key presses are taken from commands of stdin or script file,
+/// or from keyboard device (evdev), and are passed to the same strategies that gamepad window uses. Other programs
+/// can send commands through automation socket.
+/// Commands, one per line, '#' starts a comment:
+///   press <key>, release <key>, tap <key> [ms] -- keys are w a s d, up down left right and 1..5
+///   wait <ms>
+///   mode standard|accelerate
+///   quit
+class HeadlessController : public QObject
+{
+	Q_OBJECT
+
+private:
+	HeadlessController(const HeadlessController &other);
+	HeadlessController & operator=(const HeadlessController &other);
+
+public:
+	HeadlessController();
+	~HeadlessController() override;
+
+	/// args have the same format as in GamepadForm::startController()
+	void startController(const QStringList &args);
+
+	/// takes commands from file, application quits when all of them are done
+	bool runScript(const QString &fileName);
+
+	/// takes commands from stdin, application quits at end of input
+	bool readStandardInput();
+
+	/// takes key presses from input device like /dev/input/event0, works until application is stopped
+	bool readDevice(const QString &deviceName);
+
+	/// takes commands from other programs through local socket, see AutomationServer
+	bool listenAutomation(const QString &path);
+
+	QString errorString() const;
+
+	/// commands sent to robot are written to journal, it should live longer than the controller
+	void setJournal(CommandJournal *journal);
+
+signals:
+	/// signals are used to execute connectionManager's methods in its thread
+	void connectionRequested();
+	void programFinished();
+
+private slots:
+	void checkSocket(QAbstractSocket::SocketState state);
+	void handleConnectionFailed();
+	void handlePadsReleased(qint64 silenceMs);
+	void sendCommand(const QString &command);
+	void appendCommand(const QString &line);
+	void finishInput();
+	void executeCommands();
+	void readStandardInputLines();
+	void readDeviceEvents();
+
+private:
+	/// returns false if next commands should wait
+	bool execute(const QString &line);
+	void setKeyState(int key, bool isPressed, bool isAutoRepeat = false);
+	void releaseAllKeys();
+	void changeMode(Strategies type);
+	void finish(int exitCode);
+
+	ConnectionManager connectionManager;
+	QThread thread;
+	Strategy *strategy;
+	bool mIsConnected;
+
+	QQueue<QString> mCommands;
+	QTimer mWaitTimer;
+	QTimer mHeartbeatTimer;
+	bool mIsInputFinished;
+	QSet<int> mPressedKeys;
+	QHash<QString, int> mKeyNames;
+
+	QSocketNotifier *mInputNotifier;
+	QByteArray mInputBuffer;
+	int mDeviceFd;
+	QSocketNotifier *mDeviceNotifier;
+	AutomationServer mAutomationServer;
+	QString mErrorString;
+};
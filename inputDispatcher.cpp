@@ -0,0 +1,129 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "inputDispatcher.h"
+
+#include <QAbstractButton>
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QKeyEvent>
+#include <QScreen>
+
+#include "strategy.h"
+#include "tracer.h"
+
+InputDispatcher::InputDispatcher(QObject *parent)
+	: QObject(parent)
+	, mStrategy(nullptr)
+	, mDispatchCount(0)
+	, mDispatchTimeNs(0)
+	, mMaxDispatchTimeNs(0)
+{
+	const QScreen *screen = QGuiApplication::primaryScreen();
+	const qreal refreshRate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60;
+	mRefreshTimer.setSingleShot(true);
+	mRefreshTimer.setInterval(qMax(1, static_cast<int>(1000 / refreshRate)));
+	connect(&mRefreshTimer, SIGNAL(timeout()), this, SLOT(refreshButtons()));
+}
+
+void InputDispatcher::setStrategy(Strategy *strategy)
+{
+	mStrategy = strategy;
+}
+
+void InputDispatcher::addButton(int key, QAbstractButton *button)
+{
+	mButtonIndices.insert(key, mButtons.size());
+	mButtons.append(button);
+	mCheckedStates.append(false);
+	mChangedStates.append(false);
+}
+
+void InputDispatcher::dispatch(QKeyEvent *event)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	{
+		TraceSpan span("Strategy::processEvent", static_cast<quint64>(event->key()));
+		mStrategy->processEvent(event);
+	}
+
+	const qint64 dispatchTimeNs = timer.nsecsElapsed();
+	++mDispatchCount;
+	mDispatchTimeNs += dispatchTimeNs;
+	mMaxDispatchTimeNs = qMax(mMaxDispatchTimeNs, dispatchTimeNs);
+
+	const auto index = mButtonIndices.constFind(event->key());
+	if (index != mButtonIndices.constEnd()) {
+		setButtonChecked(index.value(), event->type() == QEvent::KeyPress);
+	}
+}
+
+void InputDispatcher::releaseAll()
+{
+	for (int i = 0; i < mButtons.size(); ++i) {
+		setButtonChecked(i, false);
+	}
+}
+
+void InputDispatcher::takeLatency(qint64 &averageNs, qint64 &maxNs)
+{
+	averageNs = mDispatchCount > 0 ? mDispatchTimeNs / mDispatchCount : 0;
+	maxNs = mMaxDispatchTimeNs;
+	mDispatchCount = 0;
+	mDispatchTimeNs = 0;
+	mMaxDispatchTimeNs = 0;
+}
+
+bool InputDispatcher::isReceivingInput(const QWidget *window)
+{
+	return window->isActiveWindow() && QApplication::activeModalWidget() == nullptr;
+}
+
+bool InputDispatcher::eventFilter(QObject *watched, QEvent *event)
+{
+	Q_UNUSED(watched)
+
+	const QEvent::Type type = event->type();
+	if (type == QEvent::KeyPress || type == QEvent::KeyRelease) {
+		TraceSpan span("eventFilter");
+		dispatch(static_cast<QKeyEvent *>(event));
+	}
+
+	return false;
+}
+
+void InputDispatcher::refreshButtons()
+{
+	for (int i = 0; i < mButtons.size(); ++i) {
+		if (mChangedStates[i]) {
+			mChangedStates[i] = false;
+			mButtons[i]->setChecked(mCheckedStates[i]);
+		}
+	}
+}
+
+void InputDispatcher::setButtonChecked(int index, bool isChecked)
+{
+	mCheckedStates[index] = isChecked;
+	mChangedStates[index] = true;
+	if (!mRefreshTimer.isActive()) {
+		mRefreshTimer.start();
+	}
+}
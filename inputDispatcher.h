@@ -0,0 +1,82 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QTimer>
+
+class QAbstractButton;
+class QKeyEvent;
+class QWidget;
+class Strategy;
+
+/// Passes key events to command-generating strategy as early as possible. Only key events are looked at,
+/// the strategy gets them before any GUI work, and highlighting of on-screen buttons is postponed
+/// and done for all changed buttons at once, not more often than display refreshes.
+class InputDispatcher : public QObject
+{
+	Q_OBJECT
+
+private:
+	InputDispatcher(const InputDispatcher &other);
+	InputDispatcher & operator=(const InputDispatcher &other);
+
+public:
+	explicit InputDispatcher(QObject *parent = nullptr);
+
+	void setStrategy(Strategy *strategy);
+
+	/// button that is highlighted while its key is pressed
+	void addButton(int key, QAbstractButton *button);
+
+	/// passes key event to strategy and schedules highlighting of the corresponding button
+	void dispatch(QKeyEvent *event);
+
+	/// unchecks all buttons
+	void releaseAll();
+
+	/// average and maximal time that strategy takes to handle key event since previous call, in nanoseconds.
+	/// Time of the command on its way to socket is not included, it is in statistics of scheduler
+	void takeLatency(qint64 &averageNs, qint64 &maxNs);
+
+	/// returns false if key events do not reach given window now, e.g. while a modal dialog is open, so releases
+	/// of keys would be missed and input can not be considered alive
+	static bool isReceivingInput(const QWidget *window);
+
+	bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+	void refreshButtons();
+
+private:
+	void setButtonChecked(int index, bool isChecked);
+
+	Strategy *mStrategy; /// Does not have ownership
+
+	QHash<int, int> mButtonIndices;
+	QVector<QAbstractButton *> mButtons;
+	QVector<bool> mCheckedStates;
+	QVector<bool> mChangedStates;
+	QTimer mRefreshTimer;
+
+	qint64 mDispatchCount;
+	qint64 mDispatchTimeNs;
+	qint64 mMaxDispatchTimeNs;
+};
@@ -33,21 +33,186 @@
  * */
 
 #include <QtWidgets/QApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QTimer>
+
+#include <cstdio>
+#include <cstring>
+
 #include "gamepadForm.h"
+#include "headlessController.h"
+#include "commandJournal.h"
+#include "startupProfiler.h"
+#include "tracer.h"
 
-int main(int argc, char *argv[])
+namespace {
+const char headlessOptionName[] = "headless";
+
+/// application object is chosen before arguments can be parsed, so the option is looked for by hand
+bool isHeadless(int argc, char *argv[])
 {
-	QApplication a(argc, argv);
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--headless") == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// expected format of arguments is the prefix of given below line:
+/// gamepadIp gamepadPort cameraPort cameraIp
+/// if you specify some of the parametres the rest would get default value
+QStringList parseArguments(const QCoreApplication &application, QCommandLineParser &parser)
+{
+	// settings of gamepad are stored with QSettings under these names
+	QCoreApplication::setOrganizationName("CyberTech Labs");
+	QCoreApplication::setApplicationName("TRIK Gamepad");
+
+	parser.addHelpOption();
+	// arguments go in this order, each of them can be given only together with all previous ones
+	parser.addPositionalArgument("gamepadIp", "Address of robot. Without it gamepad does not connect at start "
+			"and shows connection dialog instead, headless mode needs it.", "[gamepadIp]");
+	parser.addPositionalArgument("gamepadPort", "Port of gamepad on robot, 4444 if not given.", "[gamepadPort]");
+	parser.addPositionalArgument("cameraPort", "Port of camera, 8080 if not given.", "[cameraPort]");
+	parser.addPositionalArgument("cameraIp", "Address of camera, gamepadIp if not given.", "[cameraIp]");
+	parser.addOption(QCommandLineOption("startup-profile", "Print durations of startup phases."));
+	parser.addOption(QCommandLineOption("journal", "Write every command sent to robot to given binary journal, "
+			"it can be replayed by journalReplay tool.", "file"));
+	parser.addOption(QCommandLineOption("trace", "Record timeline of input, commands and video, it is written "
+			"to given file at exit and by menu action in Chrome trace event format.", "file"));
+	parser.addOption(QCommandLineOption("automation", "Take commands from other programs through given local socket, "
+			"see README.md for the protocol.", "socket"));
+	parser.addOption(QCommandLineOption(headlessOptionName
+			, "Control robot without GUI and video, commands are read from stdin unless --script, --device "
+			"or --automation is given."));
+	parser.addOption(QCommandLineOption("script", "Headless mode: file with commands to run.", "file"));
+	parser.addOption(QCommandLineOption("device", "Headless mode: keyboard device to read, like /dev/input/event0."
+			, "device"));
+	parser.process(application);
+
+	StartupProfiler::setEnabled(parser.isSet("startup-profile"));
+	StartupProfiler::mark("application");
+
+	Tracer::setEnabled(parser.isSet("trace"));
+	Tracer::setThreadName("main");
+
+	return QStringList(application.applicationFilePath()) + parser.positionalArguments();
+}
+
+bool openJournal(const QCommandLineParser &parser, CommandJournal &journal)
+{
+	if (parser.isSet("journal") && !journal.open(parser.value("journal"))) {
+		fprintf(stderr, "Couldn't open journal: %s\n", qPrintable(journal.errorString()));
+		return false;
+	}
+
+	return true;
+}
+
+void dumpTrace(const QCommandLineParser &parser)
+{
+	QString errorString;
+	if (parser.isSet("trace") && !Tracer::dump(parser.value("trace"), errorString)) {
+		fprintf(stderr, "Couldn't write trace: %s\n", qPrintable(errorString));
+	}
+}
+
+int runHeadless(QCoreApplication &application)
+{
+	QCommandLineParser parser;
+	const QStringList args = parseArguments(application, parser);
+	if (args.size() < 2) {
+		fprintf(stderr, "Address of robot is required in headless mode\n");
+		return 1;
+	}
+
+	CommandJournal journal;
+	if (!openJournal(parser, journal)) {
+		return 1;
+	}
+
+	HeadlessController controller;
+	controller.setJournal(journal.isOpen() ? &journal : nullptr);
+	if (parser.isSet("automation") && !controller.listenAutomation(parser.value("automation"))) {
+		fprintf(stderr, "%s\n", qPrintable(controller.errorString()));
+		return 1;
+	}
+
+	bool isStarted = false;
+	if (parser.isSet("script")) {
+		isStarted = controller.runScript(parser.value("script"));
+	} else if (parser.isSet("device")) {
+		isStarted = controller.readDevice(parser.value("device"));
+	} else if (parser.isSet("automation")) {
+		// other programs are the only input, controller works until application is stopped
+		isStarted = true;
+	} else {
+		isStarted = controller.readStandardInput();
+	}
+
+	if (!isStarted) {
+		fprintf(stderr, "%s\n", qPrintable(controller.errorString()));
+		return 1;
+	}
+
+	controller.startController(args);
+	StartupProfiler::mark("headless controller");
+	StartupProfiler::report();
+
+	const int result = application.exec();
+	dumpTrace(parser);
+	return result;
+}
+
+int runGui(QApplication &application)
+{
+	QCommandLineParser parser;
+	const QStringList args = parseArguments(application, parser);
+
+	// gamepad works without journal if it can not be written
+	CommandJournal journal;
+	openJournal(parser, journal);
+
 	GamepadForm w;
+	w.setTraceFile(parser.value("trace"));
+	w.setJournal(journal.isOpen() ? &journal : nullptr);
+	QString errorString;
+	if (parser.isSet("automation") && !w.listenAutomation(parser.value("automation"), errorString)) {
+		// gamepad works without automation, as it works without journal
+		fprintf(stderr, "Couldn't listen automation socket: %s\n", qPrintable(errorString));
+	}
+
+	StartupProfiler::mark("main window");
 	w.show();
+	StartupProfiler::mark("show");
+
+	// connecting is started from event loop, so window is shown and responds as soon as possible
+	QTimer::singleShot(0, &w, [&w, args]() {
+		StartupProfiler::mark("first event loop iteration");
+		if (args.size() > 1) {
+			w.startController(args);
+			StartupProfiler::mark("start controller");
+		}
+
+		StartupProfiler::report();
+	});
 
-	/// expected format of arguments is the prefix of given below line:
-	/// gamepadIp gamepadPort cameraPort cameraIp
-	/// if you specify some of the parametres the rest would get default value
-	QStringList args = a.arguments();
-	if (args.size() > 1) {
-		w.startController(args);
+	const int result = application.exec();
+	dumpTrace(parser);
+	return result;
+}
+}
+
+int main(int argc, char *argv[])
+{
+	StartupProfiler::start();
+	if (isHeadless(argc, argv)) {
+		// no widgets, fonts and video are loaded in headless mode
+		QCoreApplication a(argc, argv);
+		return runHeadless(a);
 	}
 
-	return a.exec();
+	QApplication a(argc, argv);
+	return runGui(a);
 }
@@ -0,0 +1,147 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "metrics.h"
+
+#include "commandProtocol.h"
+
+namespace {
+struct Description
+{
+	const char *name;
+	const char *labels;
+
+	/// metrics with labels share one family, so only the first of them has help
+	const char *help;
+};
+
+/// in the order of Metrics::Counter
+const Description counterDescriptions[] = {
+	{"trik_gamepad_commands_total", "{type=\"pad\"}", "Commands written to socket by type."}
+	, {"trik_gamepad_commands_total", "{type=\"pad_up\"}", nullptr}
+	, {"trik_gamepad_commands_total", "{type=\"btn\"}", nullptr}
+	, {"trik_gamepad_commands_total", "{type=\"wheel\"}", nullptr}
+	, {"trik_gamepad_commands_total", "{type=\"other\"}", nullptr}
+	, {"trik_gamepad_queued_commands_total", "", "Commands passed to connection thread."}
+	, {"trik_gamepad_replaced_commands_total", "", "Pad and wheel positions replaced by newer ones before being written."}
+	, {"trik_gamepad_scheduled_commands_total", "{priority=\"urgent\"}", "Commands taken from scheduler by priority."}
+	, {"trik_gamepad_scheduled_commands_total", "{priority=\"continuous\"}", nullptr}
+	, {"trik_gamepad_command_wait_nanoseconds_total", "{priority=\"urgent\"}"
+			, "Time commands waited in scheduler by priority."}
+	, {"trik_gamepad_command_wait_nanoseconds_total", "{priority=\"continuous\"}", nullptr}
+	, {"trik_gamepad_sent_bytes_total", "", "Bytes written to socket."}
+	, {"trik_gamepad_write_failures_total", "", "Writes to socket that failed."}
+	, {"trik_gamepad_connection_attempts_total", "", "Attempts to connect to robot."}
+	, {"trik_gamepad_connection_failures_total", "", "Attempts to connect to robot that failed."}
+	, {"trik_gamepad_video_reconnects_total", "", "Reopenings of stalled camera stream."}
+	, {"trik_gamepad_video_dropped_frames_total", "", "Frames received from camera that were not shown."}
+	, {"trik_gamepad_dead_man_releases_total", "", "Releases of held pads because input stopped responding."}
+	, {"trik_gamepad_state_resyncs_total", "", "Resending of held pads and wheel after connection."}
+	, {"trik_gamepad_telemetry_lines_total", "", "Lines that robot has sent to gamepad."}
+	, {"trik_gamepad_telemetry_invalid_lines_total", "", "Lines of robot that are not \"key value\" ones."}
+	, {"trik_gamepad_telemetry_dropped_samples_total", "", "Telemetry values that were dropped before being shown."}
+};
+
+/// in the order of Metrics::Gauge
+const Description gaugeDescriptions[] = {
+	{"trik_gamepad_video_received_fps", "", "Frames per second received from camera."}
+	, {"trik_gamepad_video_presented_fps", "", "Frames per second shown."}
+	, {"trik_gamepad_video_decoded_fps", "", "Frames per second decoded."}
+	, {"trik_gamepad_video_decode_milliseconds", "", "Average time of decoding of a frame."}
+	, {"trik_gamepad_command_queue_depth", "{priority=\"urgent\"}", "Commands waiting in scheduler by priority."}
+	, {"trik_gamepad_command_queue_depth", "{priority=\"continuous\"}", nullptr}
+	, {"trik_gamepad_dead_man_detection_milliseconds", ""
+			, "Time without input heartbeats when the last stall was detected."}
+	, {"trik_gamepad_resync_milliseconds", "", "Time from link up until the last resent state was written to network."}
+	, {"trik_gamepad_video_snapshot_interval_milliseconds", "", "Interval between snapshot requests when polling."}
+};
+
+static_assert(sizeof(counterDescriptions) / sizeof(counterDescriptions[0]) == Metrics::countersCount
+		, "every counter needs description");
+static_assert(sizeof(gaugeDescriptions) / sizeof(gaugeDescriptions[0]) == Metrics::gaugesCount
+		, "every gauge needs description");
+}
+
+std::atomic<quint64> Metrics::counters[countersCount];
+std::atomic<double> Metrics::gauges[gaugesCount];
+
+void Metrics::add(Counter counter, quint64 value)
+{
+	counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+quint64 Metrics::value(Counter counter)
+{
+	return counters[counter].load(std::memory_order_relaxed);
+}
+
+void Metrics::set(Gauge gauge, double value)
+{
+	gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+double Metrics::value(Gauge gauge)
+{
+	return gauges[gauge].load(std::memory_order_relaxed);
+}
+
+void Metrics::addCommand(const GamepadCommand &command)
+{
+	switch (command.type) {
+	case GamepadCommand::Type::pad:
+		add(padCommands);
+		break;
+	case GamepadCommand::Type::padUp:
+		add(padUpCommands);
+		break;
+	case GamepadCommand::Type::button:
+		add(buttonCommands);
+		break;
+	case GamepadCommand::Type::wheel:
+		add(wheelCommands);
+		break;
+	case GamepadCommand::Type::invalid:
+		add(otherCommands);
+		break;
+	}
+}
+
+QByteArray Metrics::exposition()
+{
+	QByteArray result;
+	for (int i = 0; i < countersCount; ++i) {
+		if (counterDescriptions[i].help) {
+			result += QByteArray("# HELP ") + counterDescriptions[i].name + ' ' + counterDescriptions[i].help + '\n'
+					+ "# TYPE " + counterDescriptions[i].name + " counter\n";
+		}
+
+		result += QByteArray(counterDescriptions[i].name) + counterDescriptions[i].labels + ' '
+				+ QByteArray::number(value(static_cast<Counter>(i))) + '\n';
+	}
+
+	for (int i = 0; i < gaugesCount; ++i) {
+		if (gaugeDescriptions[i].help) {
+			result += QByteArray("# HELP ") + gaugeDescriptions[i].name + ' ' + gaugeDescriptions[i].help + '\n'
+					+ "# TYPE " + gaugeDescriptions[i].name + " gauge\n";
+		}
+
+		result += QByteArray(gaugeDescriptions[i].name) + gaugeDescriptions[i].labels + ' '
+				+ QByteArray::number(value(static_cast<Gauge>(i)), 'g', 6) + '\n';
+	}
+
+	return result;
+}
@@ -0,0 +1,96 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QByteArray>
+
+#include <atomic>
+
+struct GamepadCommand;
+
+/// Counters and gauges of gamepad that are served by MetricsServer in Prometheus text format.
+/// Values are atomic, so they are updated from any thread without locks, and updating costs the same
+/// whether metrics are served or not.
+class Metrics
+{
+public:
+	enum Counter {
+		padCommands
+		, padUpCommands
+		, buttonCommands
+		, wheelCommands
+		, otherCommands
+		/// commands passed to connection thread
+		, queuedCommands
+		/// positions of pads and wheel that were replaced by newer ones before being written
+		, replacedCommands
+		/// commands taken from CommandScheduler and time they waited there, by priority
+		, urgentScheduledCommands
+		, continuousScheduledCommands
+		, urgentWaitNs
+		, continuousWaitNs
+		, bytesSent
+		, writeFailures
+		, connectionAttempts
+		, connectionFailures
+		, videoReconnects
+		, droppedFrames
+		/// releases of held pads by DeadManWatchdog
+		, deadManReleases
+		/// resending of held state after connection
+		, stateResyncs
+		/// lines that robot has sent back, invalid ones are counted among them too
+		, telemetryLines
+		, telemetryInvalidLines
+		/// parsed values that were not taken by GUI in time
+		, telemetryDroppedSamples
+		, countersCount
+	};
+
+	enum Gauge {
+		receivedFps
+		, presentedFps
+		, decodedFps
+		, decodeMs
+		, urgentQueueDepth
+		, continuousQueueDepth
+		/// time without heartbeats at the moment of the last stall detection
+		, deadManDetectionMs
+		/// time from link up until the last resent state left socket
+		, resyncMs
+		/// interval between requests of snapshot polling, 0 while video is streamed
+		, snapshotIntervalMs
+		, gaugesCount
+	};
+
+	static void add(Counter counter, quint64 value = 1);
+	static quint64 value(Counter counter);
+
+	static void set(Gauge gauge, double value);
+	static double value(Gauge gauge);
+
+	/// counts written command by its type
+	static void addCommand(const GamepadCommand &command);
+
+	/// all metrics in Prometheus text exposition format
+	static QByteArray exposition();
+
+private:
+	static std::atomic<quint64> counters[countersCount];
+	static std::atomic<double> gauges[gaugesCount];
+};
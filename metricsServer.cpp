@@ -0,0 +1,139 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "metricsServer.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include "metrics.h"
+
+namespace {
+/// longer requests are not from Prometheus, connection is closed
+const int maxRequestSize = 8 * 1024;
+
+/// running gamepad answers at once, it is local socket
+const int probeTimeoutMs = 100;
+}
+
+MetricsServer::MetricsServer(QObject *parent)
+	: QObject(parent)
+	, mTcpServer(nullptr)
+	, mLocalServer(nullptr)
+{
+}
+
+void MetricsServer::listen(const QString &address, quint16 port)
+{
+	if (!mTcpServer) {
+		mTcpServer = new QTcpServer(this);
+		connect(mTcpServer, SIGNAL(newConnection()), this, SLOT(acceptTcpConnections()));
+	}
+
+	if (!mTcpServer->listen(QHostAddress(address), port)) {
+		emit failed(mTcpServer->errorString());
+	}
+}
+
+void MetricsServer::listenLocal(const QString &path)
+{
+	if (!mLocalServer) {
+		mLocalServer = new QLocalServer(this);
+		connect(mLocalServer, SIGNAL(newConnection()), this, SLOT(acceptLocalConnections()));
+	}
+
+	// socket of a crashed gamepad may be left in file system, it does not answer unlike the one of a running gamepad
+	QLocalSocket probe;
+	probe.connectToServer(path);
+	if (probe.waitForConnected(probeTimeoutMs)) {
+		emit failed(tr("Another program listens on %1").arg(path));
+		return;
+	}
+
+	QLocalServer::removeServer(path);
+	if (!mLocalServer->listen(path)) {
+		emit failed(mLocalServer->errorString());
+	}
+}
+
+void MetricsServer::close()
+{
+	if (mTcpServer) {
+		mTcpServer->close();
+	}
+
+	if (mLocalServer) {
+		mLocalServer->close();
+	}
+}
+
+void MetricsServer::acceptTcpConnections()
+{
+	while (mTcpServer->hasPendingConnections()) {
+		addConnection(mTcpServer->nextPendingConnection());
+	}
+}
+
+void MetricsServer::acceptLocalConnections()
+{
+	while (mLocalServer->hasPendingConnections()) {
+		addConnection(mLocalServer->nextPendingConnection());
+	}
+}
+
+void MetricsServer::addConnection(QIODevice *connection)
+{
+	mRequests.insert(connection, QByteArray());
+	connect(connection, SIGNAL(readyRead()), this, SLOT(readRequest()));
+	// both socket types have disconnected() signal, it is not in QIODevice
+	connect(connection, SIGNAL(disconnected()), connection, SLOT(deleteLater()));
+	connect(connection, &QObject::destroyed, this, [this, connection]() { mRequests.remove(connection); });
+}
+
+void MetricsServer::readRequest()
+{
+	QIODevice *connection = qobject_cast<QIODevice *>(sender());
+	if (!connection || !mRequests.contains(connection)) {
+		return;
+	}
+
+	QByteArray &request = mRequests[connection];
+	request += connection->readAll();
+	if (!request.contains("\r\n\r\n") && request.size() < maxRequestSize) {
+		return;
+	}
+
+	const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+	const QByteArray path = requestLine.size() > 1 ? requestLine.at(1) : QByteArray();
+	mRequests.remove(connection);
+
+	if (requestLine.first() == "GET" && (path == "/metrics" || path == "/")) {
+		const QByteArray body = Metrics::exposition();
+		connection->write("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+				+ QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+	} else {
+		connection->write("HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+	}
+
+	if (QAbstractSocket *socket = qobject_cast<QAbstractSocket *>(connection)) {
+		socket->disconnectFromHost();
+	} else if (QLocalSocket *socket = qobject_cast<QLocalSocket *>(connection)) {
+		socket->disconnectFromServer();
+	}
+}
@@ -0,0 +1,62 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+
+class QIODevice;
+class QTcpServer;
+class QLocalServer;
+
+/// Serves Metrics over HTTP in Prometheus text format, on TCP port or on Unix socket.
+/// Lives in its own thread, so scraping does not touch GUI thread and is not delayed by it.
+class MetricsServer : public QObject
+{
+	Q_OBJECT
+
+private:
+	MetricsServer(const MetricsServer &other);
+	MetricsServer & operator=(const MetricsServer &other);
+
+public:
+	explicit MetricsServer(QObject *parent = nullptr);
+
+public slots:
+	/// slots shall be invoked after server is moved to its thread, servers are created there
+	void listen(const QString &address, quint16 port);
+	void listenLocal(const QString &path);
+	void close();
+
+signals:
+	void failed(const QString &errorString);
+
+private slots:
+	void acceptTcpConnections();
+	void acceptLocalConnections();
+	void readRequest();
+
+private:
+	void addConnection(QIODevice *connection);
+
+	QTcpServer *mTcpServer;
+	QLocalServer *mLocalServer;
+
+	/// requests that are not completely received yet
+	QHash<QIODevice *, QByteArray> mRequests;
+};
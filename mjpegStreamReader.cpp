@@ -0,0 +1,347 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "mjpegStreamReader.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+
+#include <chrono>
+
+namespace {
+/// stream is considered broken if there is no frame in so many bytes
+const int maxBufferSize = 8 * 1024 * 1024;
+
+/// snapshots are requested at least that often, so video watchdog does not take polling for a stall
+const int maxSnapshotIntervalMs = 2000;
+
+/// limits of the part of link time that snapshots take, it grows by the step while control is not congested
+const double minVideoShare = 0.05;
+const double maxVideoShare = 0.5;
+const double videoShareStep = 0.05;
+
+/// control connection is considered congested if pad commands wait for it longer on average,
+/// or if so much data waits in its socket, which is the case when positions are streamed past the scheduler
+const double congestedWaitMs = 10;
+const qint64 congestedBytesToWrite = 256;
+}
+
+MjpegStreamReader::MjpegStreamReader(QObject *parent)
+	: QObject(parent)
+	, mNetworkManager(new QNetworkAccessManager(this))
+	, mReply(nullptr)
+	, mParserState(ParserState::boundary)
+	, mContentLength(-1)
+	, mSequence(0)
+	, mHasFrames(false)
+	, mMode(Mode::stream)
+	, mMinSnapshotIntervalMs(100)
+	, mSnapshotIntervalMs(0)
+	, mSnapshotDownloadMs(0)
+	, mVideoShare(maxVideoShare)
+{
+	mSnapshotTimer.setSingleShot(true);
+	connect(&mSnapshotTimer, SIGNAL(timeout()), this, SLOT(requestSnapshot()));
+}
+
+MjpegStreamReader::~MjpegStreamReader()
+{
+	stop();
+}
+
+void MjpegStreamReader::setMode(Mode mode)
+{
+	mMode = mode;
+}
+
+MjpegStreamReader::Mode MjpegStreamReader::mode() const
+{
+	return mMode;
+}
+
+void MjpegStreamReader::setMaxSnapshotRate(int framesPerSecond)
+{
+	mMinSnapshotIntervalMs = qBound(1, 1000 / qMax(1, framesPerSecond), maxSnapshotIntervalMs);
+}
+
+void MjpegStreamReader::setControlLoad(double averageWaitMs, qint64 peakBytesToWrite)
+{
+	// multiplicative decrease and additive increase, so video yields to control quickly and comes back slowly
+	if (averageWaitMs > congestedWaitMs || peakBytesToWrite > congestedBytesToWrite) {
+		mVideoShare = qMax(minVideoShare, mVideoShare / 2);
+	} else {
+		mVideoShare = qMin(maxVideoShare, mVideoShare + videoShareStep);
+	}
+}
+
+int MjpegStreamReader::snapshotIntervalMs() const
+{
+	return mMode == Mode::snapshot ? mSnapshotIntervalMs : 0;
+}
+
+double MjpegStreamReader::snapshotDownloadMs() const
+{
+	return mMode == Mode::snapshot ? mSnapshotDownloadMs : 0;
+}
+
+bool MjpegStreamReader::isActive() const
+{
+	// snapshot mode has no request between snapshots, waiting for the next one is activity too
+	return mReply != nullptr || mSnapshotTimer.isActive();
+}
+
+QUrl MjpegStreamReader::url() const
+{
+	return mUrl;
+}
+
+qint64 MjpegStreamReader::timestamp()
+{
+	using namespace std::chrono;
+	return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void MjpegStreamReader::start(const QUrl &url)
+{
+	stop();
+
+	mUrl = url;
+	if (mMode == Mode::snapshot) {
+		mSnapshotIntervalMs = 0;
+		mSnapshotDownloadMs = 0;
+		requestSnapshot();
+		return;
+	}
+
+	QNetworkRequest request(url);
+	request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+	request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+	mReply = mNetworkManager->get(request);
+	connect(mReply, SIGNAL(readyRead()), this, SLOT(readFrames()));
+	connect(mReply, SIGNAL(finished()), this, SLOT(handleFinished()));
+}
+
+void MjpegStreamReader::stop()
+{
+	mSnapshotTimer.stop();
+	if (mReply) {
+		QNetworkReply *reply = mReply;
+		mReply = nullptr;
+		disconnect(reply, nullptr, this, nullptr);
+		reply->abort();
+		reply->deleteLater();
+	}
+
+	resetParser();
+}
+
+void MjpegStreamReader::readFrames()
+{
+	if (!mReply) {
+		return;
+	}
+
+	if (mBoundary.isEmpty()) {
+		// mjpg-streamer sends "multipart/x-mixed-replace;boundary=<boundary>"
+		const QByteArray contentType = mReply->rawHeader("Content-Type");
+		const int position = contentType.indexOf("boundary=");
+		if (position == -1) {
+			const QString error = tr("Camera does not send MJPEG stream");
+			stop();
+			emit failed(error);
+			return;
+		}
+
+		mBoundary = "--" + contentType.mid(position + 9).trimmed();
+		if (mBoundary.startsWith("----")) {
+			// some servers already put leading dashes into boundary parameter
+			mBoundary = mBoundary.mid(2);
+		}
+	}
+
+	mBuffer += mReply->readAll();
+	parse();
+
+	if (mBuffer.size() > maxBufferSize) {
+		mBuffer.clear();
+		mParserState = ParserState::boundary;
+	}
+}
+
+void MjpegStreamReader::handleFinished()
+{
+	if (!mReply) {
+		return;
+	}
+
+	if (mMode == Mode::snapshot && mReply->error() == QNetworkReply::NoError) {
+		handleSnapshot();
+		return;
+	}
+
+	const bool isFailed = mReply->error() != QNetworkReply::NoError;
+	const QString error = mReply->errorString();
+	stop();
+	if (isFailed) {
+		emit failed(error);
+	} else {
+		emit finished();
+	}
+}
+
+void MjpegStreamReader::requestSnapshot()
+{
+	QNetworkRequest request(mUrl);
+	request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+	request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+	mSnapshotRequestTimer.start();
+	mReply = mNetworkManager->get(request);
+	connect(mReply, SIGNAL(finished()), this, SLOT(handleFinished()));
+}
+
+void MjpegStreamReader::handleSnapshot()
+{
+	QNetworkReply *reply = mReply;
+	mReply = nullptr;
+	reply->deleteLater();
+	const QByteArray jpeg = reply->readAll();
+	if (jpeg.isEmpty()) {
+		stop();
+		emit failed(tr("Camera sends empty snapshots"));
+		return;
+	}
+
+	const double downloadMs = mSnapshotRequestTimer.nsecsElapsed() / 1e6;
+	mSnapshotDownloadMs = mSnapshotDownloadMs > 0 ? mSnapshotDownloadMs * 0.75 + downloadMs * 0.25 : downloadMs;
+
+	// snapshot that downloads for D ms is requested every D / share ms, so link is left free for the rest of time;
+	// the next request is sent only after this one is done, there is never more than one of them in flight
+	mSnapshotIntervalMs = qBound(mMinSnapshotIntervalMs, qRound(mSnapshotDownloadMs / mVideoShare)
+			, maxSnapshotIntervalMs);
+	mSnapshotTimer.start(qMax(0, mSnapshotIntervalMs - qRound(downloadMs)));
+
+	if (!mHasFrames) {
+		mHasFrames = true;
+		emit started();
+	}
+
+	emit frameReceived(jpeg, mSequence++, timestamp());
+}
+
+void MjpegStreamReader::parse()
+{
+	bool hasProgress = true;
+	while (hasProgress) {
+		switch (mParserState) {
+		case ParserState::boundary:
+			hasProgress = parseBoundary();
+			break;
+		case ParserState::headers:
+			hasProgress = parseHeaders();
+			break;
+		case ParserState::body:
+			hasProgress = parseBody();
+			break;
+		}
+	}
+}
+
+bool MjpegStreamReader::parseBoundary()
+{
+	const int position = mBuffer.indexOf(mBoundary);
+	if (position == -1) {
+		// keeping tail that may contain beginning of boundary
+		if (mBuffer.size() > mBoundary.size()) {
+			mBuffer.remove(0, mBuffer.size() - mBoundary.size());
+		}
+
+		return false;
+	}
+
+	const int lineEnd = mBuffer.indexOf("\r\n", position);
+	if (lineEnd == -1) {
+		return false;
+	}
+
+	mBuffer.remove(0, lineEnd + 2);
+	mParserState = ParserState::headers;
+	return true;
+}
+
+bool MjpegStreamReader::parseHeaders()
+{
+	const int headersEnd = mBuffer.indexOf("\r\n\r\n");
+	if (headersEnd == -1) {
+		return false;
+	}
+
+	mContentLength = -1;
+	const QList<QByteArray> lines = mBuffer.left(headersEnd).split('\n');
+	for (const QByteArray &line : lines) {
+		const int separator = line.indexOf(':');
+		if (separator != -1 && line.left(separator).trimmed().toLower() == "content-length") {
+			bool ok = false;
+			const int length = line.mid(separator + 1).trimmed().toInt(&ok);
+			mContentLength = ok ? length : -1;
+		}
+	}
+
+	mBuffer.remove(0, headersEnd + 4);
+	mParserState = ParserState::body;
+	return true;
+}
+
+bool MjpegStreamReader::parseBody()
+{
+	int frameSize = mContentLength;
+	if (frameSize < 0) {
+		// no Content-Length, so frame lasts up to the next boundary
+		const int position = mBuffer.indexOf(mBoundary);
+		if (position == -1) {
+			return false;
+		}
+
+		frameSize = position;
+		while (frameSize > 0 && (mBuffer.at(frameSize - 1) == '\n' || mBuffer.at(frameSize - 1) == '\r')) {
+			--frameSize;
+		}
+	} else if (mBuffer.size() < frameSize) {
+		return false;
+	}
+
+	const QByteArray frame = mBuffer.left(frameSize);
+	mBuffer.remove(0, frameSize);
+	mParserState = ParserState::boundary;
+
+	if (!mHasFrames) {
+		mHasFrames = true;
+		emit started();
+	}
+
+	emit frameReceived(frame, mSequence++, timestamp());
+	return true;
+}
+
+void MjpegStreamReader::resetParser()
+{
+	mBuffer.clear();
+	mBoundary.clear();
+	mParserState = ParserState::boundary;
+	mContentLength = -1;
+	mHasFrames = false;
+}
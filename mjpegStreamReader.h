@@ -0,0 +1,130 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QUrl>
+#include <QByteArray>
+#include <QTimer>
+#include <QElapsedTimer>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+/// Reads multipart MJPEG stream (as served by mjpg-streamer on TRIK) and splits it into separate JPEG frames.
+/// Frames are not decoded here, so compressed data can be kept or saved as is.
+/// In snapshot mode single frames are requested one after another instead, so video does not take more of a weak
+/// link than is left by control commands: the next request is sent only when the previous one is done, at a rate
+/// that follows download time of frames and congestion of control connection.
+class MjpegStreamReader : public QObject
+{
+	Q_OBJECT
+
+private:
+	MjpegStreamReader(const MjpegStreamReader &other);
+	MjpegStreamReader & operator=(const MjpegStreamReader &other);
+
+public:
+	enum class Mode {
+		/// url is a multipart stream, like "?action=stream" of mjpg-streamer
+		stream
+		/// url returns one JPEG frame, like "?action=snapshot" of mjpg-streamer
+		, snapshot
+	};
+
+	explicit MjpegStreamReader(QObject *parent = nullptr);
+	~MjpegStreamReader() override;
+
+	/// is applied by the next start()
+	void setMode(Mode mode);
+	Mode mode() const;
+
+	/// snapshots are not requested more often than that
+	void setMaxSnapshotRate(int framesPerSecond);
+
+	/// average time that pad commands waited in scheduler for control connection and the largest amount of data
+	/// that waited in its socket during the last period, snapshots become rarer while any of them is high
+	/// and more frequent again while both are low
+	void setControlLoad(double averageWaitMs, qint64 peakBytesToWrite);
+
+	/// interval between starts of snapshot requests and smoothed download time of a snapshot, 0 in stream mode
+	int snapshotIntervalMs() const;
+	double snapshotDownloadMs() const;
+
+	/// returns true if request to camera is opened
+	bool isActive() const;
+
+	QUrl url() const;
+
+	/// monotonic time in milliseconds that is used for frame timestamps
+	static qint64 timestamp();
+
+public slots:
+	/// opens stream with given url, previous stream is closed
+	void start(const QUrl &url);
+	void stop();
+
+signals:
+	/// emitted when first frame of the stream is received
+	void started();
+	void frameReceived(const QByteArray &jpeg, quint64 sequence, qint64 timestamp);
+	void failed(const QString &errorString);
+	void finished();
+
+private slots:
+	void readFrames();
+	void handleFinished();
+	void requestSnapshot();
+
+private:
+	enum class ParserState {
+		boundary
+		, headers
+		, body
+	};
+
+	void handleSnapshot();
+	void parse();
+	bool parseBoundary();
+	bool parseHeaders();
+	bool parseBody();
+	void resetParser();
+
+	QNetworkAccessManager *mNetworkManager;
+	QNetworkReply *mReply; /// Has ownership
+	QUrl mUrl;
+
+	QByteArray mBuffer;
+	QByteArray mBoundary;
+	ParserState mParserState;
+	int mContentLength;
+
+	/// sequence numbers are not reset on restart, so frames of different streams never mix up
+	quint64 mSequence;
+	bool mHasFrames;
+
+	Mode mMode;
+	QTimer mSnapshotTimer;
+	QElapsedTimer mSnapshotRequestTimer;
+	int mMinSnapshotIntervalMs;
+	int mSnapshotIntervalMs;
+	double mSnapshotDownloadMs;
+
+	/// part of time that link is busy with snapshots, it is halved when control connection is congested
+	double mVideoShare;
+};
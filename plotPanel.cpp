@@ -0,0 +1,210 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "plotPanel.h"
+
+#include <QPainter>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QPolygonF>
+
+#include <cmath>
+
+namespace {
+const int margin = 4;
+}
+
+PlotPanel::PlotPanel(QWidget *parent)
+	: QWidget(parent)
+	, mWindowNs(10 * 1000000000LL)
+	, mSeriesCapacity(256 * 1024)
+	, mHasNewSamples(false)
+	, mLastTimestampNs(0)
+{
+	setAttribute(Qt::WA_OpaquePaintEvent);
+	setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+	setMinimumHeight(120);
+	connect(&mRedrawTimer, SIGNAL(timeout()), this, SLOT(redraw()));
+}
+
+void PlotPanel::setWindow(int seconds)
+{
+	mWindowNs = qMax(1, seconds) * 1000000000LL;
+	update();
+}
+
+void PlotPanel::setSeriesCapacity(int samples)
+{
+	mSeriesCapacity = qMax(1, samples);
+}
+
+QSize PlotPanel::sizeHint() const
+{
+	return QSize(640, 200);
+}
+
+void PlotPanel::addSample(const QByteArray &name, double value, qint64 timestampNs)
+{
+	if (!isVisible()) {
+		return;
+	}
+
+	const int index = seriesIndex(name);
+	if (index == -1 || !std::isfinite(value)) {
+		return;
+	}
+
+	mSeries[index].append(timestampNs, value);
+	mLastTimestampNs = qMax(mLastTimestampNs, timestampNs);
+	mHasNewSamples = true;
+}
+
+void PlotPanel::addTelemetry(const QVector<TelemetrySample> &samples)
+{
+	if (!isVisible()) {
+		return;
+	}
+
+	for (const TelemetrySample &sample : samples) {
+		addSample(sample.key, sample.value, sample.timestampNs);
+	}
+}
+
+void PlotPanel::clear()
+{
+	mNames.clear();
+	mSeries.clear();
+	mColumns.clear();
+	mHasNewSamples = false;
+	mLastTimestampNs = 0;
+	update();
+}
+
+void PlotPanel::showEvent(QShowEvent *event)
+{
+	QWidget::showEvent(event);
+	const QScreen *screen = QGuiApplication::primaryScreen();
+	const qreal refreshRate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60;
+	mRedrawTimer.start(qMax(1, qRound(1000 / refreshRate)));
+}
+
+void PlotPanel::hideEvent(QHideEvent *event)
+{
+	QWidget::hideEvent(event);
+	mRedrawTimer.stop();
+}
+
+void PlotPanel::redraw()
+{
+	// plot scrolls while the latest sample is in the window, after that there is nothing new to draw
+	if (mHasNewSamples || TelemetryReader::timestamp() - mLastTimestampNs < mWindowNs) {
+		mHasNewSamples = false;
+		update();
+	}
+}
+
+int PlotPanel::seriesIndex(const QByteArray &name)
+{
+	const int index = mNames.indexOf(name);
+	if (index != -1 || mNames.size() == maxSeries) {
+		return index;
+	}
+
+	mNames.append(name);
+	mSeries.append(PlotSeries(mSeriesCapacity));
+	mColumns.append(QVector<PlotSeries::Column>());
+	return mNames.size() - 1;
+}
+
+void PlotPanel::paintEvent(QPaintEvent *event)
+{
+	Q_UNUSED(event)
+
+	QPainter painter(this);
+	painter.fillRect(rect(), Qt::black);
+
+	const int legendHeight = fontMetrics().height();
+	const QRect plot = rect().adjusted(margin, margin + legendHeight, -margin, -margin);
+	if (mSeries.isEmpty() || plot.width() <= 0 || plot.height() <= 0) {
+		return;
+	}
+
+	const qint64 now = TelemetryReader::timestamp();
+	float min = 0;
+	float max = 0;
+	bool hasValues = false;
+	for (int i = 0; i < mSeries.size(); ++i) {
+		QVector<PlotSeries::Column> &columns = mColumns[i];
+		columns.resize(plot.width());
+		mSeries.at(i).decimate(now - mWindowNs, now, columns);
+		for (const PlotSeries::Column &column : columns) {
+			if (!column.isEmpty) {
+				min = hasValues ? qMin(min, column.min) : column.min;
+				max = hasValues ? qMax(max, column.max) : column.max;
+				hasValues = true;
+			}
+		}
+	}
+
+	if (max - min < 1e-6f) {
+		min -= 1;
+		max += 1;
+	}
+
+	auto y = [&plot, min, max](float value) {
+		return plot.bottom() - (value - min) * (plot.height() - 1) / (max - min);
+	};
+
+	painter.setPen(Qt::darkGray);
+	if (min < 0 && max > 0) {
+		painter.drawLine(QPointF(plot.left(), y(0)), QPointF(plot.right(), y(0)));
+	}
+
+	painter.drawText(plot, Qt::AlignLeft | Qt::AlignTop, QString::number(max, 'g', 4));
+	painter.drawText(plot, Qt::AlignLeft | Qt::AlignBottom, QString::number(min, 'g', 4));
+	painter.drawText(plot, Qt::AlignRight | Qt::AlignBottom, tr("%1 s").arg(mWindowNs / 1000000000));
+
+	// every column is drawn as a vertical stroke from max to min, strokes of neighbouring columns are joined
+	// from the end of one to the start of the other, so the polyline goes through all extremes
+	QPolygonF line;
+	int legendX = plot.left();
+	for (int i = 0; i < mSeries.size(); ++i) {
+		const QColor color = QColor::fromHsv(i * 360 / maxSeries, 200, 255);
+		painter.setPen(color);
+
+		line.clear();
+		const QVector<PlotSeries::Column> &columns = mColumns.at(i);
+		for (int x = 0; x < columns.size(); ++x) {
+			const PlotSeries::Column &column = columns.at(x);
+			if (column.isEmpty) {
+				continue;
+			}
+
+			const bool isDownward = line.isEmpty() || line.last().y() <= y(column.max);
+			line << QPointF(plot.left() + x, y(isDownward ? column.max : column.min))
+					<< QPointF(plot.left() + x, y(isDownward ? column.min : column.max));
+		}
+
+		painter.drawPolyline(line);
+
+		const QString legend = QString::fromLatin1(mNames.at(i)) + ": "
+				+ QString::number(mSeries.at(i).lastValue(), 'g', 4) + "   ";
+		QRect drawn;
+		painter.drawText(QRect(legendX, margin, width(), legendHeight), Qt::AlignLeft | Qt::AlignVCenter, legend, &drawn);
+		legendX = drawn.right() + 1;
+	}
+}
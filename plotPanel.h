@@ -0,0 +1,84 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QWidget>
+#include <QTimer>
+#include <QVector>
+
+#include "plotSeries.h"
+#include "telemetryReader.h"
+
+/// Live plot of several series, e.g. telemetry of robot and pad values that gamepad sends. Adding a sample only
+/// stores it, plot is redrawn by timer at most at refresh rate of the screen, and cost of drawing depends on width
+/// of the plot, not on rate of samples, so kHz series over minutes do not slow down input handling.
+/// Samples are taken only while panel is shown.
+class PlotPanel : public QWidget
+{
+	Q_OBJECT
+
+private:
+	PlotPanel(const PlotPanel &other);
+	PlotPanel & operator=(const PlotPanel &other);
+
+public:
+	/// more series would not be told apart by color
+	static const int maxSeries = 8;
+
+	explicit PlotPanel(QWidget *parent = nullptr);
+
+	/// time window that is shown, it ends at the current moment
+	void setWindow(int seconds);
+
+	/// samples kept per series, is applied to series that are added after the call
+	void setSeriesCapacity(int samples);
+
+	QSize sizeHint() const override;
+
+public slots:
+	/// timestamp is steady clock in nanoseconds, see TelemetryReader::timestamp()
+	void addSample(const QByteArray &name, double value, qint64 timestampNs);
+	void addTelemetry(const QVector<TelemetrySample> &samples);
+	void clear();
+
+protected:
+	void paintEvent(QPaintEvent *event) override;
+	void showEvent(QShowEvent *event) override;
+	void hideEvent(QHideEvent *event) override;
+
+private slots:
+	void redraw();
+
+private:
+	/// index of series with given name, new series is added if there is a free one, -1 otherwise
+	int seriesIndex(const QByteArray &name);
+
+	QVector<QByteArray> mNames;
+	QVector<PlotSeries> mSeries;
+
+	/// decimated series of the last redraw, buffers are kept to avoid allocations on every frame
+	QVector<QVector<PlotSeries::Column>> mColumns;
+
+	qint64 mWindowNs;
+	int mSeriesCapacity;
+	QTimer mRedrawTimer;
+
+	/// true if samples were added since the last redraw
+	bool mHasNewSamples;
+	qint64 mLastTimestampNs;
+};
@@ -0,0 +1,168 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "plotSeries.h"
+
+namespace {
+/// levels are not built while they would have fewer buckets than that, such buckets are too wide to be of use
+const int minBuckets = 16;
+}
+
+PlotSeries::PlotSeries(int capacity)
+	: mCapacity(minBuckets)
+	, mCount(0)
+{
+	while (mCapacity < capacity) {
+		mCapacity *= levelFactor;
+	}
+
+	mTimestamps.resize(mCapacity);
+	mValues.resize(mCapacity);
+	for (int buckets = mCapacity / levelFactor; buckets >= minBuckets; buckets /= levelFactor) {
+		mLevels.append(QVector<Bucket>(buckets));
+	}
+}
+
+void PlotSeries::append(qint64 timestampNs, double value)
+{
+	const qint64 sample = mCount;
+	const int index = slot(sample);
+	const float number = static_cast<float>(value);
+	// timestamps are kept monotonic, so time windows are found by binary search
+	mTimestamps[index] = mCount > 0 ? qMax(timestampNs, lastTimestamp()) : timestampNs;
+	mValues[index] = number;
+
+	qint64 bucketSize = 1;
+	for (QVector<Bucket> &level : mLevels) {
+		bucketSize *= levelFactor;
+		Bucket &bucket = level[static_cast<int>((sample / bucketSize) & (level.size() - 1))];
+		if ((sample & (bucketSize - 1)) == 0) {
+			bucket = {number, number};
+		} else {
+			bucket.min = qMin(bucket.min, number);
+			bucket.max = qMax(bucket.max, number);
+		}
+	}
+
+	++mCount;
+}
+
+bool PlotSeries::isEmpty() const
+{
+	return mCount == 0;
+}
+
+int PlotSeries::capacity() const
+{
+	return mCapacity;
+}
+
+double PlotSeries::lastValue() const
+{
+	return mCount > 0 ? static_cast<double>(mValues.at(slot(mCount - 1))) : 0;
+}
+
+qint64 PlotSeries::lastTimestamp() const
+{
+	return mCount > 0 ? mTimestamps.at(slot(mCount - 1)) : 0;
+}
+
+void PlotSeries::decimate(qint64 fromNs, qint64 toNs, QVector<Column> &columns) const
+{
+	const int count = columns.size();
+	for (Column &column : columns) {
+		column = {0, 0, true};
+	}
+
+	if (count == 0 || toNs <= fromNs) {
+		return;
+	}
+
+	const qint64 first = findSample(fromNs, qMax<qint64>(0, mCount - mCapacity), mCount);
+	const qint64 end = findSample(toNs, first, mCount);
+	if (first >= end) {
+		return;
+	}
+
+	const qint64 span = toNs - fromNs;
+	qint64 sample = first;
+	while (sample < end) {
+		const qint64 column = qBound<qint64>(0, (mTimestamps.at(slot(sample)) - fromNs) * count / span, count - 1);
+		// the first sample of the next column, samples up to it are covered by the largest aligned buckets,
+		// so a column costs a few buckets at each level regardless of how many samples it has
+		const qint64 columnEnd = column == count - 1 ? end
+				: findSample(fromNs + ((column + 1) * span + count - 1) / count, sample, end);
+		Column &target = columns[static_cast<int>(column)];
+		while (sample < columnEnd) {
+			int level = 0;
+			qint64 bucketSize = 1;
+			while (level < mLevels.size() && (sample & (bucketSize * levelFactor - 1)) == 0
+					&& sample + bucketSize * levelFactor <= columnEnd) {
+				++level;
+				bucketSize *= levelFactor;
+			}
+
+			float min = 0;
+			float max = 0;
+			if (level > 0) {
+				const QVector<Bucket> &buckets = mLevels.at(level - 1);
+				const Bucket &bucket = buckets.at(static_cast<int>((sample / bucketSize) & (buckets.size() - 1)));
+				min = bucket.min;
+				max = bucket.max;
+			} else {
+				min = mValues.at(slot(sample));
+				max = min;
+			}
+
+			sample += bucketSize;
+			if (target.isEmpty) {
+				target = {min, max, false};
+			} else {
+				target.min = qMin(target.min, min);
+				target.max = qMax(target.max, max);
+			}
+		}
+	}
+}
+
+qint64 PlotSeries::findSample(qint64 timestampNs, qint64 from, qint64 to) const
+{
+	// galloping from the start first, columns of a plot usually have few samples each
+	qint64 low = from;
+	qint64 high = from;
+	for (qint64 step = 1; high < to && mTimestamps.at(slot(high)) < timestampNs; step *= 2) {
+		low = high + 1;
+		high = qMin(to, high + step);
+	}
+
+	while (low < high) {
+		const qint64 middle = low + (high - low) / 2;
+		if (mTimestamps.at(slot(middle)) < timestampNs) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+int PlotSeries::slot(qint64 sample) const
+{
+	// capacity is a power of levelFactor, so it is a power of two too
+	return static_cast<int>(sample & (mCapacity - 1));
+}
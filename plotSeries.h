@@ -0,0 +1,75 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QVector>
+
+/// Samples of one plotted value in fixed memory: the latest capacity() samples are kept in a ring, and a pyramid of
+/// min/max buckets is kept alongside, where every level merges levelFactor buckets of the level below. Plot of any
+/// time window is built from the largest buckets that fit into its columns, so its cost depends on the number of
+/// columns, not on the number of samples in the window, and spikes are never lost to decimation.
+class PlotSeries
+{
+public:
+	/// min and max of samples that fall into one column of plot
+	struct Column
+	{
+		float min;
+		float max;
+		bool isEmpty;
+	};
+
+	/// capacity is rounded up to a power of levelFactor
+	explicit PlotSeries(int capacity = 256 * 1024);
+
+	/// samples should come in the order of time, earlier timestamp is taken as the previous one
+	void append(qint64 timestampNs, double value);
+
+	bool isEmpty() const;
+	int capacity() const;
+	double lastValue() const;
+	qint64 lastTimestamp() const;
+
+	/// splits [fromNs, toNs) into columns.size() columns and fills them with min and max of samples
+	void decimate(qint64 fromNs, qint64 toNs, QVector<Column> &columns) const;
+
+private:
+	struct Bucket
+	{
+		float min;
+		float max;
+	};
+
+	/// should be a power of two, buckets and slots are found by masks
+	static const int levelFactor = 4;
+
+	/// the first sample in [from, to) that is not earlier than timestampNs, or to if there is none
+	qint64 findSample(qint64 timestampNs, qint64 from, qint64 to) const;
+
+	int slot(qint64 sample) const;
+
+	int mCapacity;
+	QVector<qint64> mTimestamps;
+	QVector<float> mValues;
+
+	/// level i has buckets of levelFactor^(i + 1) samples, ring of every level covers the same samples as mValues
+	QVector<QVector<Bucket>> mLevels;
+
+	/// samples appended since creation, sample n is kept in slot n % mCapacity
+	qint64 mCount;
+};
@@ -0,0 +1,188 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "preConnector.h"
+
+#include <QNetworkProxy>
+
+namespace {
+/// pause in editing of address after which connecting starts
+const int debounceMs = 300;
+
+/// the same timeout as ConnectionManager::connectToHost() has
+const int connectTimeoutMs = 3 * 1000;
+}
+
+PreConnector::PreConnector(QObject *parent)
+	: QObject(parent)
+	, mGamepadPort(0)
+	, mCameraPort(0)
+	, mGamepadSocket(nullptr)
+	, mCameraSocket(nullptr)
+	, mGamepadReachability(Reachability::unknown)
+	, mCameraReachability(Reachability::unknown)
+{
+	mDebounceTimer.setSingleShot(true);
+	mDebounceTimer.setInterval(debounceMs);
+	connect(&mDebounceTimer, SIGNAL(timeout()), this, SLOT(connectToTarget()));
+	mTimeoutTimer.setSingleShot(true);
+	connect(&mTimeoutTimer, SIGNAL(timeout()), this, SLOT(handleTimeout()));
+}
+
+PreConnector::~PreConnector()
+{
+	closeSockets();
+}
+
+void PreConnector::setTarget(const QString &host, quint16 gamepadPort, const QString &cameraHost, quint16 cameraPort)
+{
+	if (host.trimmed() == mHost && gamepadPort == mGamepadPort && cameraHost.trimmed() == mCameraHost
+			&& cameraPort == mCameraPort) {
+		return;
+	}
+
+	mHost = host.trimmed();
+	mGamepadPort = gamepadPort;
+	mCameraHost = cameraHost.trimmed();
+	mCameraPort = cameraPort;
+	closeSockets();
+	mGamepadReachability = Reachability::unknown;
+	mCameraReachability = Reachability::unknown;
+	emit gamepadReachabilityChanged(Reachability::unknown, 0);
+	emit cameraReachabilityChanged(Reachability::unknown, 0);
+	if (!mHost.isEmpty() && mGamepadPort != 0) {
+		mDebounceTimer.start();
+	}
+}
+
+QTcpSocket *PreConnector::takeGamepadSocket(const QString &host, quint16 port)
+{
+	if (!mGamepadSocket || host.trimmed() != mHost || port != mGamepadPort
+			|| mGamepadSocket->state() != QAbstractSocket::ConnectedState) {
+		return nullptr;
+	}
+
+	QTcpSocket *socket = mGamepadSocket;
+	mGamepadSocket = nullptr;
+	socket->disconnect(this);
+	socket->setParent(nullptr);
+	return socket;
+}
+
+void PreConnector::connectToTarget()
+{
+	closeSockets();
+	mElapsed.start();
+	mGamepadSocket = createSocket(SLOT(handleGamepadStateChanged(QAbstractSocket::SocketState)));
+	mGamepadSocket->connectToHost(mHost, mGamepadPort);
+	if (!mCameraHost.isEmpty() && mCameraPort != 0) {
+		mCameraSocket = createSocket(SLOT(handleCameraStateChanged(QAbstractSocket::SocketState)));
+		mCameraSocket->connectToHost(mCameraHost, mCameraPort);
+	}
+
+	mTimeoutTimer.start(connectTimeoutMs);
+}
+
+QTcpSocket *PreConnector::createSocket(const char *stateSlot)
+{
+	QTcpSocket *socket = new QTcpSocket(this);
+	socket->setProxy(QNetworkProxy::NoProxy);
+	connect(socket, SIGNAL(stateChanged(QAbstractSocket::SocketState)), this, stateSlot);
+	return socket;
+}
+
+void PreConnector::handleGamepadStateChanged(QAbstractSocket::SocketState state)
+{
+	Reachability reachability = mGamepadReachability;
+	switch (state) {
+	case QAbstractSocket::HostLookupState:
+		reachability = Reachability::resolving;
+		break;
+	case QAbstractSocket::ConnectingState:
+		reachability = Reachability::connecting;
+		break;
+	case QAbstractSocket::ConnectedState:
+		reachability = Reachability::reachable;
+		break;
+	case QAbstractSocket::UnconnectedState:
+		reachability = Reachability::unreachable;
+		break;
+	default:
+		break;
+	}
+
+	if (reachability != mGamepadReachability) {
+		mGamepadReachability = reachability;
+		emit gamepadReachabilityChanged(reachability, mElapsed.elapsed());
+	}
+}
+
+void PreConnector::handleCameraStateChanged(QAbstractSocket::SocketState state)
+{
+	Reachability reachability = mCameraReachability;
+	switch (state) {
+	case QAbstractSocket::HostLookupState:
+		reachability = Reachability::resolving;
+		break;
+	case QAbstractSocket::ConnectingState:
+		reachability = Reachability::connecting;
+		break;
+	case QAbstractSocket::ConnectedState:
+		reachability = Reachability::reachable;
+		// camera port is only probed, stream is opened by video pipeline
+		mCameraSocket->disconnect(this);
+		mCameraSocket->abort();
+		break;
+	case QAbstractSocket::UnconnectedState:
+		reachability = Reachability::unreachable;
+		break;
+	default:
+		break;
+	}
+
+	if (reachability != mCameraReachability) {
+		mCameraReachability = reachability;
+		emit cameraReachabilityChanged(reachability, mElapsed.elapsed());
+	}
+}
+
+void PreConnector::handleTimeout()
+{
+	if (mGamepadSocket && mGamepadSocket->state() != QAbstractSocket::ConnectedState) {
+		mGamepadSocket->abort();
+	}
+
+	if (mCameraSocket && mCameraReachability != Reachability::reachable) {
+		mCameraSocket->abort();
+	}
+}
+
+void PreConnector::closeSockets()
+{
+	mDebounceTimer.stop();
+	mTimeoutTimer.stop();
+	for (QTcpSocket *socket : {mGamepadSocket, mCameraSocket}) {
+		if (socket) {
+			socket->disconnect(this);
+			socket->abort();
+			socket->deleteLater();
+		}
+	}
+
+	mGamepadSocket = nullptr;
+	mCameraSocket = nullptr;
+}
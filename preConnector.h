@@ -0,0 +1,85 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QTcpSocket>
+
+/// Connects to robot while user is still editing its address in connection dialog: after a short pause in editing
+/// host name is resolved, connection to gamepad port is opened and camera port is probed. Connect button then
+/// takes the already open socket, so robot is controllable right away.
+class PreConnector : public QObject
+{
+	Q_OBJECT
+
+private:
+	PreConnector(const PreConnector &other);
+	PreConnector & operator=(const PreConnector &other);
+
+public:
+	enum class Reachability {
+		unknown
+		, resolving
+		, connecting
+		, reachable
+		, unreachable
+	};
+
+	explicit PreConnector(QObject *parent = nullptr);
+	~PreConnector() override;
+
+	/// connects to the target after debounce, previous connections are closed
+	void setTarget(const QString &host, quint16 gamepadPort, const QString &cameraHost, quint16 cameraPort);
+
+	/// returns connected socket of gamepad port if it is connected to given host and port, nullptr otherwise;
+	/// caller takes ownership
+	QTcpSocket *takeGamepadSocket(const QString &host, quint16 port);
+
+signals:
+	/// elapsedMs is time since connecting was started, it is meaningful for reachable endpoint
+	void gamepadReachabilityChanged(PreConnector::Reachability reachability, qint64 elapsedMs);
+	void cameraReachabilityChanged(PreConnector::Reachability reachability, qint64 elapsedMs);
+
+private slots:
+	void connectToTarget();
+	void handleGamepadStateChanged(QAbstractSocket::SocketState state);
+	void handleCameraStateChanged(QAbstractSocket::SocketState state);
+	void handleTimeout();
+
+private:
+	QTcpSocket *createSocket(const char *stateSlot);
+	void closeSockets();
+
+	QTimer mDebounceTimer;
+	QTimer mTimeoutTimer;
+	QElapsedTimer mElapsed;
+
+	QString mHost;
+	quint16 mGamepadPort;
+	QString mCameraHost;
+	quint16 mCameraPort;
+
+	QTcpSocket *mGamepadSocket; /// Has ownership
+	QTcpSocket *mCameraSocket; /// Has ownership
+	Reachability mGamepadReachability;
+	Reachability mCameraReachability;
+};
+
+Q_DECLARE_METATYPE(PreConnector::Reachability)
@@ -0,0 +1,201 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "robotScanner.h"
+
+#include <QTcpSocket>
+#include <QHostInfo>
+#include <QNetworkProxy>
+
+namespace {
+/// larger subnets would take too long and are unlikely to be a robot network
+const int minPrefixLength = 16;
+}
+
+RobotScanner::RobotScanner(QObject *parent)
+	: QObject(parent)
+	, mMaxProbes(512)
+	, mProbeTimeoutMs(300)
+	, mIsStartingProbes(false)
+	, mHosts(0)
+{
+	connect(&mTimeoutTimer, SIGNAL(timeout()), this, SLOT(abortExpiredProbes()));
+}
+
+RobotScanner::~RobotScanner()
+{
+	stop();
+}
+
+void RobotScanner::setMaxProbes(int value)
+{
+	mMaxProbes = qMax(1, value);
+}
+
+void RobotScanner::setProbeTimeout(int milliseconds)
+{
+	mProbeTimeoutMs = qMax(1, milliseconds);
+}
+
+bool RobotScanner::isScanning() const
+{
+	return !mProbes.isEmpty() || !mTargets.isEmpty();
+}
+
+bool RobotScanner::start(const QStringList &subnets, quint16 gamepadPort, quint16 cameraPort)
+{
+	stop();
+	mHosts = 0;
+	for (const QString &subnet : subnets) {
+		const QPair<QHostAddress, int> parsed = QHostAddress::parseSubnet(subnet.trimmed());
+		if (parsed.first.protocol() != QAbstractSocket::IPv4Protocol || parsed.second < minPrefixLength) {
+			continue;
+		}
+
+		const quint32 mask = parsed.second == 32 ? 0xffffffffu : ~(0xffffffffu >> parsed.second);
+		const quint32 network = parsed.first.toIPv4Address() & mask;
+		const quint32 size = ~mask + 1;
+		// network and broadcast addresses are skipped when there are other ones
+		const quint32 first = size > 2 ? 1 : 0;
+		const quint32 last = size > 2 ? size - 2 : size - 1;
+		for (quint32 i = first; i <= last; ++i) {
+			// gamepad ports of all hosts go first, they tell where robots are
+			mTargets.enqueue({network + i, gamepadPort});
+		}
+
+		// camera can share port with gamepad, such port is probed once and reported once for both of them
+		for (quint32 i = first; cameraPort != gamepadPort && i <= last; ++i) {
+			mTargets.enqueue({network + i, cameraPort});
+		}
+
+		mHosts += static_cast<int>(last - first + 1);
+	}
+
+	if (mTargets.isEmpty()) {
+		return false;
+	}
+
+	mElapsed.start();
+	mTimeoutTimer.start(qMax(10, mProbeTimeoutMs / 4));
+	startProbes();
+	return true;
+}
+
+void RobotScanner::stop()
+{
+	mTargets.clear();
+	mTimeoutTimer.stop();
+	for (QTcpSocket *socket : mProbes.keys()) {
+		socket->disconnect(this);
+		socket->abort();
+		socket->deleteLater();
+	}
+
+	mProbes.clear();
+	for (const int lookup : mLookups) {
+		QHostInfo::abortHostLookup(lookup);
+	}
+
+	mLookups.clear();
+	mNamedHosts.clear();
+}
+
+void RobotScanner::startProbes()
+{
+	if (mIsStartingProbes) {
+		return;
+	}
+
+	mIsStartingProbes = true;
+	while (mProbes.size() < mMaxProbes && !mTargets.isEmpty()) {
+		const Target target = mTargets.dequeue();
+		QTcpSocket *socket = new QTcpSocket(this);
+		socket->setProxy(QNetworkProxy::NoProxy);
+		connect(socket, SIGNAL(connected()), this, SLOT(handleConnected()));
+		connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(handleError()));
+		mProbes.insert(socket, {target, mElapsed.elapsed()});
+		socket->connectToHost(QHostAddress(target.address), target.port);
+	}
+
+	mIsStartingProbes = false;
+
+	if (mProbes.isEmpty() && mTargets.isEmpty() && mTimeoutTimer.isActive()) {
+		mTimeoutTimer.stop();
+		emit finished(mHosts, mElapsed.elapsed());
+	}
+}
+
+void RobotScanner::handleConnected()
+{
+	finishProbe(qobject_cast<QTcpSocket *>(sender()), true);
+}
+
+void RobotScanner::handleError()
+{
+	finishProbe(qobject_cast<QTcpSocket *>(sender()), false);
+}
+
+void RobotScanner::abortExpiredProbes()
+{
+	const qint64 now = mElapsed.elapsed();
+	QList<QTcpSocket *> expired;
+	for (auto probe = mProbes.constBegin(); probe != mProbes.constEnd(); ++probe) {
+		if (now - probe.value().startMs >= mProbeTimeoutMs) {
+			expired.append(probe.key());
+		}
+	}
+
+	for (QTcpSocket *socket : expired) {
+		finishProbe(socket, false);
+	}
+}
+
+void RobotScanner::finishProbe(QTcpSocket *socket, bool isOpen)
+{
+	if (!socket || !mProbes.contains(socket)) {
+		return;
+	}
+
+	const Target target = mProbes.take(socket).target;
+	const QHostAddress address(target.address);
+	socket->disconnect(this);
+	socket->abort();
+	socket->deleteLater();
+
+	if (isOpen) {
+		emit portFound(address, target.port);
+		if (!mNamedHosts.contains(target.address)) {
+			mNamedHosts.insert(target.address);
+			mLookups.append(QHostInfo::lookupHost(address.toString(), this, SLOT(handleHostInfo(QHostInfo))));
+		}
+	}
+
+	startProbes();
+}
+
+void RobotScanner::handleHostInfo(const QHostInfo &info)
+{
+	mLookups.removeOne(info.lookupId());
+	if (info.error() != QHostInfo::NoError || info.hostName().isEmpty()) {
+		return;
+	}
+
+	const QHostAddress address = info.addresses().isEmpty() ? QHostAddress() : info.addresses().first();
+	if (!address.isNull() && info.hostName() != address.toString()) {
+		emit hostNameFound(address, info.hostName());
+	}
+}
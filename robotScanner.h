@@ -0,0 +1,101 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QHostAddress>
+#include <QQueue>
+#include <QSet>
+#include <QTimer>
+#include <QElapsedTimer>
+
+class QTcpSocket;
+class QHostInfo;
+
+/// Looks for robots by connecting to gamepad and camera ports of every host of given subnets.
+/// Hundreds of non-blocking connects are in flight at once and every one has a short timeout, so a /24 subnet is
+/// scanned in about one timeout. Open ports and names of hosts are reported as soon as they are known.
+class RobotScanner : public QObject
+{
+	Q_OBJECT
+
+private:
+	RobotScanner(const RobotScanner &other);
+	RobotScanner & operator=(const RobotScanner &other);
+
+public:
+	explicit RobotScanner(QObject *parent = nullptr);
+	~RobotScanner() override;
+
+	void setMaxProbes(int value);
+	void setProbeTimeout(int milliseconds);
+
+	bool isScanning() const;
+
+	/// subnets are in "address/prefix" form, like 192.168.77.0/24, prefix should be at least 16;
+	/// returns false if none of subnets is valid
+	bool start(const QStringList &subnets, quint16 gamepadPort, quint16 cameraPort);
+	void stop();
+
+signals:
+	void portFound(const QHostAddress &address, quint16 port);
+
+	/// name of host with an open port, is resolved in background and can come after finished()
+	void hostNameFound(const QHostAddress &address, const QString &name);
+
+	void finished(int hosts, qint64 elapsedMs);
+
+private slots:
+	void handleConnected();
+	void handleError();
+	void abortExpiredProbes();
+	void handleHostInfo(const QHostInfo &info);
+
+private:
+	struct Target
+	{
+		quint32 address;
+		quint16 port;
+	};
+
+	struct Probe
+	{
+		Target target;
+		qint64 startMs;
+	};
+
+	void startProbes();
+	void finishProbe(QTcpSocket *socket, bool isOpen);
+
+	int mMaxProbes;
+	int mProbeTimeoutMs;
+
+	QQueue<Target> mTargets;
+
+	QHash<QTcpSocket *, Probe> mProbes;
+
+	/// connect can fail right away, then new probes are started by the loop that is already running
+	bool mIsStartingProbes;
+
+	QSet<quint32> mNamedHosts;
+	QList<int> mLookups;
+	QTimer mTimeoutTimer;
+	QElapsedTimer mElapsed;
+	int mHosts;
+};
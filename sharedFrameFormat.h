@@ -0,0 +1,96 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+/// Layout of shared memory ring with decoded frames of robot camera, see SharedFramePublisher.
+/// This header does not depend on Qt, so it can be used by external readers as is.
+///
+/// Memory consists of SharedFrameRingHeader followed by slotCount slots. Each slot is SharedFrameSlotHeader
+/// followed by slotSize bytes of pixels. Frame with sequence number N is written to slot N % slotCount.
+///
+/// Slot is protected by a sequence lock: writer makes `lock` odd before writing and even after it.
+/// Reader shall check that `lock` is even before reading pixels and has the same value after reading them,
+/// otherwise the slot was overwritten during reading and data shall be dropped.
+
+#include <stdint.h>
+
+namespace sharedFrames {
+
+/// 'TRKF'
+const uint32_t magic = 0x464b5254;
+const uint32_t version = 1;
+
+/// pixel formats of frames
+enum PixelFormat : uint32_t {
+	/// 32 bit per pixel, bytes are B, G, R, 0xff on little-endian machines (QImage::Format_RGB32)
+	rgb32 = 1
+	/// 8 bit per pixel
+	, grayscale8 = 2
+};
+
+struct SharedFrameRingHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t slotSize;
+
+	/// size of SharedFrameRingHeader and of SharedFrameSlotHeader, readers can use them to check compatibility
+	uint32_t ringHeaderSize;
+	uint32_t slotHeaderSize;
+
+	/// sequence number of the last completely written frame plus one, 0 if there were no frames.
+	/// Sequence numbers of published frames go without gaps, so readers can count frames they missed
+	uint64_t nextSequence;
+
+	uint8_t reserved[32];
+};
+
+struct SharedFrameSlotHeader
+{
+	uint64_t lock;
+	uint64_t sequence;
+
+	/// CLOCK_MONOTONIC time of publishing in nanoseconds
+	uint64_t timestampNs;
+
+	uint32_t size;
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;
+	uint32_t format;
+
+	uint8_t reserved[20];
+};
+
+static_assert(sizeof(SharedFrameRingHeader) == 64, "Ring header shall be 64 bytes long");
+static_assert(sizeof(SharedFrameSlotHeader) == 64, "Slot header shall be 64 bytes long");
+
+/// offset of slot with given index from the beginning of shared memory
+inline uint64_t slotOffset(uint32_t slotSize, uint32_t index)
+{
+	return sizeof(SharedFrameRingHeader) + static_cast<uint64_t>(index) * (sizeof(SharedFrameSlotHeader) + slotSize);
+}
+
+/// total size of shared memory
+inline uint64_t ringSize(uint32_t slotSize, uint32_t slotCount)
+{
+	return slotOffset(slotSize, slotCount);
+}
+
+}
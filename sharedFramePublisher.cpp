@@ -0,0 +1,335 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "sharedFramePublisher.h"
+
+#include <QSocketNotifier>
+
+#include <cerrno>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+using namespace sharedFrames;
+
+namespace {
+
+/// slots are aligned to cache lines
+const int slotAlignment = 64;
+
+#ifdef Q_OS_LINUX
+quint64 monotonicNs()
+{
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return static_cast<quint64>(time.tv_sec) * 1000000000ULL + static_cast<quint64>(time.tv_nsec);
+}
+
+/// fills address of socket in abstract namespace, returns its length
+socklen_t abstractAddress(const QString &name, sockaddr_un &address)
+{
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	const QByteArray path = name.toLocal8Bit().mid(name.startsWith('/') ? 1 : 0).left(sizeof(address.sun_path) - 2);
+	memcpy(address.sun_path + 1, path.constData(), static_cast<size_t>(path.size()));
+	return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + static_cast<size_t>(path.size()));
+}
+#endif
+
+}
+
+SharedFramePublisher::SharedFramePublisher(QObject *parent)
+	: QObject(parent)
+	, mShmFd(-1)
+	, mMemory(nullptr)
+	, mSize(0)
+	, mHeader(nullptr)
+	, mNextSequence(0)
+	, mServerSocket(-1)
+	, mServerNotifier(nullptr)
+{
+}
+
+SharedFramePublisher::~SharedFramePublisher()
+{
+	close();
+}
+
+bool SharedFramePublisher::open(const QString &name, int slotCount, int slotSize)
+{
+	close();
+
+#ifdef Q_OS_LINUX
+	if (slotCount < 1 || slotSize < 1) {
+		return fail(tr("Wrong size of shared memory ring"));
+	}
+
+	mName = name;
+	const quint32 alignedSlotSize = static_cast<quint32>((slotSize + slotAlignment - 1) / slotAlignment * slotAlignment);
+	mSize = static_cast<size_t>(ringSize(alignedSlotSize, static_cast<quint32>(slotCount)));
+
+	// socket is bound first, it is owned by one process only and disappears with it, so a second instance fails here
+	// instead of clearing and then unlinking ring of the first one
+	mServerSocket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	sockaddr_un address;
+	const socklen_t addressLength = abstractAddress(name, address);
+	if (mServerSocket == -1
+			|| bind(mServerSocket, reinterpret_cast<sockaddr *>(&address), addressLength) == -1
+			|| listen(mServerSocket, 8) == -1) {
+		return fail(tr("Couldn't create socket for readers of %1: %2").arg(name).arg(strerror(errno)));
+	}
+
+	const QByteArray shmName = name.toLocal8Bit();
+	mShmFd = shm_open(shmName.constData(), O_CREAT | O_RDWR, 0600);
+	if (mShmFd == -1 || ftruncate(mShmFd, static_cast<off_t>(mSize)) == -1) {
+		return fail(tr("Couldn't create shared memory %1: %2").arg(name).arg(strerror(errno)));
+	}
+
+	void *memory = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, mShmFd, 0);
+	if (memory == MAP_FAILED) {
+		return fail(tr("Couldn't map shared memory %1: %2").arg(name).arg(strerror(errno)));
+	}
+
+	mMemory = static_cast<uchar *>(memory);
+	memset(mMemory, 0, mSize);
+	mHeader = reinterpret_cast<SharedFrameRingHeader *>(mMemory);
+	mHeader->version = version;
+	mHeader->slotCount = static_cast<quint32>(slotCount);
+	mHeader->slotSize = alignedSlotSize;
+	mHeader->ringHeaderSize = sizeof(SharedFrameRingHeader);
+	mHeader->slotHeaderSize = sizeof(SharedFrameSlotHeader);
+	// magic is written the last, so readers never see half-initialized header
+	__atomic_store_n(&mHeader->magic, magic, __ATOMIC_RELEASE);
+
+	mServerNotifier = new QSocketNotifier(mServerSocket, QSocketNotifier::Read, this);
+	connect(mServerNotifier, SIGNAL(activated(int)), this, SLOT(acceptReader()));
+	return true;
+#else
+	Q_UNUSED(name)
+	Q_UNUSED(slotCount)
+	Q_UNUSED(slotSize)
+	return fail(tr("Shared memory export is supported on Linux only"));
+#endif
+}
+
+void SharedFramePublisher::close()
+{
+#ifdef Q_OS_LINUX
+	while (!mReaders.isEmpty()) {
+		removeReader(0);
+	}
+
+	delete mServerNotifier;
+	mServerNotifier = nullptr;
+	if (mServerSocket != -1) {
+		::close(mServerSocket);
+		mServerSocket = -1;
+	}
+
+	if (mMemory) {
+		munmap(mMemory, mSize);
+		mMemory = nullptr;
+		mHeader = nullptr;
+	}
+
+	if (mShmFd != -1) {
+		::close(mShmFd);
+		mShmFd = -1;
+		shm_unlink(mName.toLocal8Bit().constData());
+	}
+#endif
+
+	mNextSequence = 0;
+}
+
+bool SharedFramePublisher::isOpen() const
+{
+	return mServerNotifier != nullptr;
+}
+
+QString SharedFramePublisher::errorString() const
+{
+	return mError;
+}
+
+bool SharedFramePublisher::publish(const uchar *data, int width, int height, int stride, PixelFormat format)
+{
+	if (!isOpen()) {
+		return false;
+	}
+
+	const quint64 size = static_cast<quint64>(stride) * static_cast<quint64>(height);
+	if (size > mHeader->slotSize) {
+		return false;
+	}
+
+#ifdef Q_OS_LINUX
+	const quint64 sequence = mNextSequence++;
+	const quint32 index = static_cast<quint32>(sequence % mHeader->slotCount);
+	uchar *slotMemory = mMemory + slotOffset(mHeader->slotSize, index);
+	SharedFrameSlotHeader *slot = reinterpret_cast<SharedFrameSlotHeader *>(slotMemory);
+
+	const quint64 lock = __atomic_load_n(&slot->lock, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->lock, lock + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	slot->sequence = sequence;
+	slot->timestampNs = monotonicNs();
+	slot->size = static_cast<quint32>(size);
+	slot->width = static_cast<quint32>(width);
+	slot->height = static_cast<quint32>(height);
+	slot->stride = static_cast<quint32>(stride);
+	slot->format = format;
+	memcpy(slotMemory + sizeof(SharedFrameSlotHeader), data, static_cast<size_t>(size));
+
+	__atomic_store_n(&slot->lock, lock + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&mHeader->nextSequence, sequence + 1, __ATOMIC_RELEASE);
+
+	const uint64_t increment = 1;
+	for (const Reader &reader : mReaders) {
+		// eventfd is non-blocking, so a reader that does not read it can not stall publishing
+		const ssize_t written = write(reader.eventFd, &increment, sizeof(increment));
+		Q_UNUSED(written)
+	}
+
+	return true;
+#else
+	Q_UNUSED(data)
+	Q_UNUSED(width)
+	Q_UNUSED(format)
+	return false;
+#endif
+}
+
+quint64 SharedFramePublisher::publishedFrames() const
+{
+	return mNextSequence;
+}
+
+int SharedFramePublisher::readersCount() const
+{
+	return mReaders.size();
+}
+
+void SharedFramePublisher::publishImage(const QImage &image)
+{
+	if (!isOpen() || image.isNull()) {
+		return;
+	}
+
+	if (image.format() == QImage::Format_Grayscale8) {
+		publish(image.constBits(), image.width(), image.height(), image.bytesPerLine(), grayscale8);
+	} else if (image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32) {
+		publish(image.constBits(), image.width(), image.height(), image.bytesPerLine(), rgb32);
+	} else {
+		const QImage converted = image.convertToFormat(QImage::Format_RGB32);
+		publish(converted.constBits(), converted.width(), converted.height(), converted.bytesPerLine(), rgb32);
+	}
+}
+
+void SharedFramePublisher::acceptReader()
+{
+#ifdef Q_OS_LINUX
+	const int readerSocket = accept4(mServerSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (readerSocket == -1) {
+		return;
+	}
+
+	const int eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (eventFd == -1) {
+		::close(readerSocket);
+		return;
+	}
+
+	// name of shared memory goes as data, eventfd as ancillary data
+	QByteArray name = mName.toLocal8Bit();
+	iovec data;
+	data.iov_base = name.data();
+	data.iov_len = static_cast<size_t>(name.size());
+
+	char control[CMSG_SPACE(sizeof(int))];
+	memset(control, 0, sizeof(control));
+	msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &data;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	cmsghdr *controlMessage = CMSG_FIRSTHDR(&message);
+	controlMessage->cmsg_level = SOL_SOCKET;
+	controlMessage->cmsg_type = SCM_RIGHTS;
+	controlMessage->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(controlMessage), &eventFd, sizeof(int));
+
+	if (sendmsg(readerSocket, &message, MSG_NOSIGNAL) == -1) {
+		::close(eventFd);
+		::close(readerSocket);
+		return;
+	}
+
+	QSocketNotifier *notifier = new QSocketNotifier(readerSocket, QSocketNotifier::Read, this);
+	connect(notifier, SIGNAL(activated(int)), this, SLOT(checkReader(int)));
+	mReaders.append({readerSocket, eventFd, notifier});
+#endif
+}
+
+void SharedFramePublisher::checkReader(int socket)
+{
+#ifdef Q_OS_LINUX
+	for (int i = 0; i < mReaders.size(); ++i) {
+		if (mReaders[i].socket == socket) {
+			// readers never send anything, so readable socket means it was closed
+			char buffer[16];
+			if (recv(socket, buffer, sizeof(buffer), MSG_DONTWAIT) <= 0) {
+				removeReader(i);
+			}
+
+			return;
+		}
+	}
+#else
+	Q_UNUSED(socket)
+#endif
+}
+
+bool SharedFramePublisher::fail(const QString &error)
+{
+	mError = error;
+	close();
+	return false;
+}
+
+void SharedFramePublisher::removeReader(int index)
+{
+	const Reader reader = mReaders.takeAt(index);
+	reader.notifier->setEnabled(false);
+	reader.notifier->deleteLater();
+#ifdef Q_OS_LINUX
+	::close(reader.eventFd);
+	::close(reader.socket);
+#endif
+}
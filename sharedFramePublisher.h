@@ -0,0 +1,91 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+
+#include "sharedFrameFormat.h"
+
+class QSocketNotifier;
+
+/// Publishes decoded frames to POSIX shared memory ring, so other processes on the same computer can use video
+/// of robot camera without opening one more stream to robot. Layout of the ring is described in sharedFrameFormat.h.
+///
+/// Readers connect to Unix domain socket in abstract namespace with the same name as shared memory (without leading
+/// slash). On connection reader receives name of shared memory as message data and an eventfd in SCM_RIGHTS
+/// ancillary message. Counter of the eventfd is incremented after each published frame.
+/// Works on Linux only, open() fails on other systems.
+class SharedFramePublisher : public QObject
+{
+	Q_OBJECT
+
+private:
+	SharedFramePublisher(const SharedFramePublisher &other);
+	SharedFramePublisher & operator=(const SharedFramePublisher &other);
+
+public:
+	explicit SharedFramePublisher(QObject *parent = nullptr);
+	~SharedFramePublisher() override;
+
+	/// creates shared memory with given name (like "/trik-gamepad-frames") and socket for readers
+	bool open(const QString &name, int slotCount, int slotSize);
+	void close();
+	bool isOpen() const;
+	QString errorString() const;
+
+	/// copies frame to the next slot of ring and notifies readers, returns false if frame does not fit into slot
+	bool publish(const uchar *data, int width, int height, int stride, sharedFrames::PixelFormat format);
+
+	/// number of frames published since open()
+	quint64 publishedFrames() const;
+
+	int readersCount() const;
+
+public slots:
+	void publishImage(const QImage &image);
+
+private slots:
+	void acceptReader();
+	void checkReader(int socket);
+
+private:
+	struct Reader
+	{
+		int socket;
+		int eventFd;
+		QSocketNotifier *notifier;
+	};
+
+	bool fail(const QString &error);
+	void removeReader(int index);
+
+	QString mName;
+	int mShmFd;
+	uchar *mMemory;
+	size_t mSize;
+	sharedFrames::SharedFrameRingHeader *mHeader;
+	quint64 mNextSequence;
+
+	int mServerSocket;
+	QSocketNotifier *mServerNotifier;
+	QList<Reader> mReaders;
+
+	QString mError;
+};
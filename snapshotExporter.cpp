@@ -0,0 +1,169 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "snapshotExporter.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QRunnable>
+
+namespace {
+
+/// writes one frame to file, is run on the pool of exporter
+class SaveFrameTask : public QRunnable
+{
+public:
+	SaveFrameTask(QObject *exporter, int sessionId, const QByteArray &jpeg, const QString &path, bool isPng)
+		: mExporter(exporter)
+		, mSessionId(sessionId)
+		, mJpeg(jpeg)
+		, mPath(path)
+		, mIsPng(isPng)
+	{
+	}
+
+	void run() override
+	{
+		bool isSaved = false;
+		if (mIsPng) {
+			QImage image;
+			isSaved = image.loadFromData(mJpeg, "JPG") && image.save(mPath, "PNG");
+		} else {
+			QFile file(mPath);
+			isSaved = file.open(QIODevice::WriteOnly) && file.write(mJpeg) == mJpeg.size();
+		}
+
+		QMetaObject::invokeMethod(mExporter, "handleFrameSaved", Qt::QueuedConnection
+				, Q_ARG(int, mSessionId), Q_ARG(bool, isSaved));
+	}
+
+private:
+	QObject *mExporter;
+	int mSessionId;
+	QByteArray mJpeg;
+	QString mPath;
+	bool mIsPng;
+};
+
+}
+
+SnapshotExporter::SnapshotExporter(QObject *parent)
+	: QObject(parent)
+	, mDirectory(QDir::currentPath())
+	, mFormat(Format::jpeg)
+	, mSessionId(0)
+	, mLastSessionId(0)
+	, mNextIndex(0)
+{
+}
+
+SnapshotExporter::~SnapshotExporter()
+{
+	// tasks post their results to this object, so they shall not outlive it
+	mPool.waitForDone();
+}
+
+void SnapshotExporter::setDirectory(const QString &directory)
+{
+	mDirectory = directory;
+}
+
+void SnapshotExporter::setFormat(Format format)
+{
+	mFormat = format;
+}
+
+bool SnapshotExporter::beginSession()
+{
+	finishSession();
+	const QString name = "trik-gamepad-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz");
+	QDir directory(mDirectory);
+	if (!directory.mkpath(name)) {
+		return false;
+	}
+
+	mSessionId = ++mLastSessionId;
+	mSessions.insert(mSessionId, {directory.filePath(name), true, 0, 0, 0});
+	mNextIndex = 0;
+	return true;
+}
+
+QString SnapshotExporter::sessionDirectory() const
+{
+	const auto session = mSessions.constFind(mSessionId);
+	return session != mSessions.constEnd() ? session->directory : QString();
+}
+
+void SnapshotExporter::exportFrames(const QVector<BufferedFrame> &frames)
+{
+	for (const BufferedFrame &frame : frames) {
+		exportFrame(frame);
+	}
+}
+
+void SnapshotExporter::exportFrame(const BufferedFrame &frame)
+{
+	if (mSessionId == 0) {
+		return;
+	}
+
+	Session &session = mSessions[mSessionId];
+	const bool isPng = mFormat == Format::png;
+	const QString fileName = QString("frame-%1.%2").arg(mNextIndex++, 5, 10, QChar('0')).arg(isPng ? "png" : "jpg");
+	++session.pendingFrames;
+	mPool.start(new SaveFrameTask(this, mSessionId, frame.jpeg, QDir(session.directory).filePath(fileName), isPng));
+}
+
+void SnapshotExporter::handleFrameSaved(int sessionId, bool isSaved)
+{
+	const auto session = mSessions.find(sessionId);
+	if (session == mSessions.end()) {
+		return;
+	}
+
+	--session->pendingFrames;
+	if (isSaved) {
+		++session->savedFrames;
+	} else {
+		++session->failedFrames;
+	}
+
+	emitIfFinished(sessionId);
+}
+
+void SnapshotExporter::finishSession()
+{
+	if (mSessionId != 0) {
+		const int sessionId = mSessionId;
+		mSessionId = 0;
+		mSessions[sessionId].isOpen = false;
+		emitIfFinished(sessionId);
+	}
+}
+
+void SnapshotExporter::emitIfFinished(int sessionId)
+{
+	// frames are saved faster than camera gives them, so pending ones may run out while session still goes on
+	const auto session = mSessions.find(sessionId);
+	if (session != mSessions.end() && !session->isOpen && session->pendingFrames == 0) {
+		const Session finished = session.value();
+		mSessions.erase(session);
+		emit exportFinished(finished.directory, finished.savedFrames, finished.failedFrames);
+	}
+}
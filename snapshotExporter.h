@@ -0,0 +1,93 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QThreadPool>
+#include <QVector>
+
+#include "frameRingBuffer.h"
+
+/// Saves frames of camera stream to numbered files. JPEG frames are written as is, PNG encoding is done in
+/// parallel on a thread pool, so GUI thread is never blocked by file operations.
+class SnapshotExporter : public QObject
+{
+	Q_OBJECT
+
+private:
+	SnapshotExporter(const SnapshotExporter &other);
+	SnapshotExporter & operator=(const SnapshotExporter &other);
+
+public:
+	enum class Format {
+		jpeg
+		, png
+	};
+
+	explicit SnapshotExporter(QObject *parent = nullptr);
+	~SnapshotExporter() override;
+
+	void setDirectory(const QString &directory);
+	void setFormat(Format format);
+
+	/// creates new directory for numbered files, following frames are saved there. Session that is still open
+	/// is finished, frames that it has not written yet are counted to it
+	bool beginSession();
+
+	/// directory of current session
+	QString sessionDirectory() const;
+
+	/// adds frames to current session, numbering continues from previously added frames
+	void exportFrames(const QVector<BufferedFrame> &frames);
+	void exportFrame(const BufferedFrame &frame);
+
+	/// no more frames are added to current session
+	void finishSession();
+
+signals:
+	/// emitted once per session, when it is finished and all its frames are written
+	void exportFinished(const QString &directory, int savedFrames, int failedFrames);
+
+private slots:
+	void handleFrameSaved(int sessionId, bool isSaved);
+
+private:
+	struct Session
+	{
+		QString directory;
+		bool isOpen;
+		int pendingFrames;
+		int savedFrames;
+		int failedFrames;
+	};
+
+	void emitIfFinished(int sessionId);
+
+	QThreadPool mPool;
+	QString mDirectory;
+	Format mFormat;
+
+	/// sessions that are open or have frames being written, by their ids
+	QHash<int, Session> mSessions;
+
+	/// id of the session that takes new frames, 0 if there is none
+	int mSessionId;
+	int mLastSessionId;
+	int mNextIndex;
+};
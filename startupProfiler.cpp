@@ -0,0 +1,68 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "startupProfiler.h"
+
+#include <cstdio>
+
+bool StartupProfiler::isProfiling = false;
+QElapsedTimer StartupProfiler::timer;
+qint64 StartupProfiler::lastMarkNs = 0;
+QVector<QPair<const char *, qint64>> StartupProfiler::phases;
+
+void StartupProfiler::start()
+{
+	timer.start();
+	lastMarkNs = 0;
+	phases.clear();
+}
+
+void StartupProfiler::setEnabled(bool isEnabled)
+{
+	isProfiling = isEnabled;
+}
+
+bool StartupProfiler::isEnabled()
+{
+	return isProfiling;
+}
+
+void StartupProfiler::mark(const char *phase)
+{
+	if (!isProfiling) {
+		return;
+	}
+
+	const qint64 now = timer.nsecsElapsed();
+	phases.append(qMakePair(phase, now - lastMarkNs));
+	lastMarkNs = now;
+}
+
+void StartupProfiler::report()
+{
+	if (!isProfiling) {
+		return;
+	}
+
+	fprintf(stderr, "Startup profile:\n");
+	for (const auto &phase : phases) {
+		fprintf(stderr, "  %-32s %8.2f ms\n", phase.first, phase.second / 1e6);
+	}
+
+	fprintf(stderr, "  %-32s %8.2f ms\n", "total", lastMarkNs / 1e6);
+	isProfiling = false;
+}
@@ -0,0 +1,47 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QVector>
+#include <QPair>
+#include <QElapsedTimer>
+
+/// Collects durations of startup phases of gamepad, so it can be seen what makes it start slowly.
+/// Is turned on by --startup-profile command line option, otherwise all calls do nothing.
+class StartupProfiler
+{
+public:
+	/// starts measuring, should be called as early in main() as possible
+	static void start();
+
+	/// marks are collected only if profiler is enabled, time is counted from start() anyway
+	static void setEnabled(bool isEnabled);
+	static bool isEnabled();
+
+	/// marks end of a phase that began at previous mark, phase should be a string literal, it is stored as a pointer
+	static void mark(const char *phase);
+
+	/// prints all phases to stderr and stops measuring
+	static void report();
+
+private:
+	static bool isProfiling;
+	static QElapsedTimer timer;
+	static qint64 lastMarkNs;
+	static QVector<QPair<const char *, qint64>> phases;
+};
@@ -30,18 +30,25 @@ void Strategy::reset()
 
 Strategy *Strategy::getStrategy(Strategies type)
 {
-	if (instances.empty()) {
-		createInstances();
+	if (!instances.contains(type)) {
+		Strategy *instance = createInstance(type);
+		if (!instance)
+			return nullptr;
+
+		instances.insert(type, QSharedPointer<Strategy>(instance));
 	}
 
-	if (instances.keys().contains(type))
-		return instances.value(type).data();
-	else
-		return nullptr;
+	return instances.value(type).data();
 }
 
-void Strategy::createInstances()
+Strategy *Strategy::createInstance(Strategies type)
 {
-	instances.insert(standartStrategy, QSharedPointer<Strategy>(new StandardStrategy));
-	instances.insert(accelerateStrategy, QSharedPointer<Strategy>(new AccelerateStrategy));
+	switch (type) {
+	case standartStrategy:
+		return new StandardStrategy;
+	case accelerateStrategy:
+		return new AccelerateStrategy;
+	}
+
+	return nullptr;
 }
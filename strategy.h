@@ -46,7 +46,8 @@ signals:
 
 
 private:
-	static void createInstances();
+	/// instances are created on first request, so unused strategy costs nothing
+	static Strategy *createInstance(Strategies type);
 
 	static QMap<Strategies, QSharedPointer<Strategy> > instances;
 
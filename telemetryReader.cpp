@@ -0,0 +1,213 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "telemetryReader.h"
+
+#include <QIODevice>
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+/// the longest line that is parsed, it should fit into a buffer on stack
+const int maxLineLength = 256;
+
+/// robot script can print anything, so there are at most so many different keys
+const int maxKeys = 256;
+}
+
+TelemetryReader::TelemetryReader(int bufferSize, int maxSamples)
+	: mRing(qMax(bufferSize, maxLineLength), '\0')
+	, mStart(0)
+	, mSize(0)
+	, mScanned(0)
+	, mIsSkippingLine(false)
+	, mMaxSamples(maxSamples)
+	, mLines(0)
+	, mInvalidLines(0)
+	, mDroppedSamples(0)
+{
+}
+
+void TelemetryReader::read(QIODevice *device)
+{
+	const qint64 timestampNs = timestamp();
+	while (device->bytesAvailable() > 0) {
+		if (mSize == mRing.size()) {
+			// no line end in the whole buffer, line is too long
+			if (!mIsSkippingLine) {
+				++mLines;
+				++mInvalidLines;
+			}
+
+			mStart = 0;
+			mSize = 0;
+			mScanned = 0;
+			mIsSkippingLine = true;
+		}
+
+		// free space up to the end of ring or up to the start of data
+		const int end = (mStart + mSize) % mRing.size();
+		const int freeSize = end >= mStart ? mRing.size() - end : mStart - end;
+		const qint64 result = device->read(mRing.data() + end, qMin(freeSize, mRing.size() - mSize));
+		if (result <= 0) {
+			break;
+		}
+
+		mSize += static_cast<int>(result);
+		parseLines(timestampNs);
+	}
+}
+
+QVector<TelemetrySample> TelemetryReader::takeSamples()
+{
+	QVector<TelemetrySample> result;
+	result.swap(mSamples);
+	mSamples.reserve(result.size());
+	return result;
+}
+
+bool TelemetryReader::hasSamples() const
+{
+	return !mSamples.isEmpty();
+}
+
+void TelemetryReader::reset()
+{
+	mStart = 0;
+	mSize = 0;
+	mScanned = 0;
+	mIsSkippingLine = false;
+}
+
+quint64 TelemetryReader::lines() const
+{
+	return mLines;
+}
+
+quint64 TelemetryReader::invalidLines() const
+{
+	return mInvalidLines;
+}
+
+quint64 TelemetryReader::droppedSamples() const
+{
+	return mDroppedSamples;
+}
+
+qint64 TelemetryReader::timestamp()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void TelemetryReader::parseLines(qint64 timestampNs)
+{
+	const int capacity = mRing.size();
+	const char *data = mRing.constData();
+	while (mScanned < mSize) {
+		const int position = (mStart + mScanned) % capacity;
+		const int contiguous = qMin(mSize - mScanned, capacity - position);
+		const char *lineEnd = static_cast<const char *>(memchr(data + position, '\n', static_cast<size_t>(contiguous)));
+		if (!lineEnd) {
+			mScanned += contiguous;
+			continue;
+		}
+
+		mScanned += static_cast<int>(lineEnd - (data + position));
+		const int length = mScanned;
+		if (mIsSkippingLine) {
+			mIsSkippingLine = false;
+		} else if (length > maxLineLength) {
+			++mLines;
+			++mInvalidLines;
+		} else {
+			// line can wrap around the end of ring, so it is copied
+			char line[maxLineLength];
+			const int firstPart = qMin(length, capacity - mStart);
+			memcpy(line, data + mStart, static_cast<size_t>(firstPart));
+			memcpy(line + firstPart, data, static_cast<size_t>(length - firstPart));
+			parseLine(line, length, timestampNs);
+		}
+
+		mStart = (mStart + length + 1) % capacity;
+		mSize -= length + 1;
+		mScanned = 0;
+	}
+}
+
+void TelemetryReader::parseLine(const char *line, int length, qint64 timestampNs)
+{
+	// "key value" with any spaces or tabs around, '\r' of Windows line ends is trimmed too
+	auto isSpace = [](char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	};
+
+	int keyStart = 0;
+	while (keyStart < length && isSpace(line[keyStart])) {
+		++keyStart;
+	}
+
+	int keyEnd = keyStart;
+	while (keyEnd < length && !isSpace(line[keyEnd])) {
+		++keyEnd;
+	}
+
+	int valueStart = keyEnd;
+	while (valueStart < length && isSpace(line[valueStart])) {
+		++valueStart;
+	}
+
+	int valueEnd = length;
+	while (valueEnd > valueStart && isSpace(line[valueEnd - 1])) {
+		--valueEnd;
+	}
+
+	if (keyEnd == keyStart) {
+		// empty lines are not counted at all
+		return;
+	}
+
+	++mLines;
+	bool ok = false;
+	const double value = QByteArray::fromRawData(line + valueStart, valueEnd - valueStart).toDouble(&ok);
+	if (!ok || valueStart == keyEnd) {
+		++mInvalidLines;
+		return;
+	}
+
+	const QByteArray rawKey = QByteArray::fromRawData(line + keyStart, keyEnd - keyStart);
+	auto key = mKeys.constFind(rawKey);
+	if (key == mKeys.constEnd()) {
+		if (mKeys.size() >= maxKeys) {
+			++mInvalidLines;
+			return;
+		}
+
+		const QByteArray copy(line + keyStart, keyEnd - keyStart);
+		key = mKeys.insert(copy, copy);
+	}
+
+	if (mSamples.size() >= mMaxSamples) {
+		// nobody takes samples fast enough, the oldest half is dropped at once to keep it cheap
+		const int dropped = mSamples.size() / 2;
+		mSamples.remove(0, dropped);
+		mDroppedSamples += static_cast<quint64>(dropped);
+	}
+
+	mSamples.append({key.value(), value, timestampNs});
+}
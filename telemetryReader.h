@@ -0,0 +1,88 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMetaType>
+#include <QVector>
+
+class QIODevice;
+
+/// One value of robot telemetry, "key value" line that robot script prints to gamepad connection.
+struct TelemetrySample
+{
+	QByteArray key;
+	double value;
+
+	/// steady clock in nanoseconds at the moment the line was read
+	qint64 timestampNs;
+};
+
+Q_DECLARE_METATYPE(QVector<TelemetrySample>)
+
+/// Reads lines that robot sends back over gamepad connection without blocking and parses "key value" ones.
+/// Data goes to a fixed ring buffer, and lines are parsed incrementally as they are completed, so memory does not
+/// grow with whatever robot prints; too long lines are skipped. Samples are kept until they are taken,
+/// the oldest of them are dropped if nobody takes them.
+class TelemetryReader
+{
+public:
+	explicit TelemetryReader(int bufferSize = 64 * 1024, int maxSamples = 64 * 1024);
+
+	/// reads everything that is available from device
+	void read(QIODevice *device);
+
+	/// samples parsed since previous call
+	QVector<TelemetrySample> takeSamples();
+
+	bool hasSamples() const;
+
+	/// drops incomplete line, e.g. when connection is closed
+	void reset();
+
+	quint64 lines() const;
+	quint64 invalidLines() const;
+	quint64 droppedSamples() const;
+
+	static qint64 timestamp();
+
+private:
+	void parseLines(qint64 timestampNs);
+	void parseLine(const char *line, int length, qint64 timestampNs);
+
+	QByteArray mRing;
+	int mStart;
+	int mSize;
+
+	/// bytes after mStart that are known to have no '\n'
+	int mScanned;
+
+	/// true while the rest of too long line is being skipped
+	bool mIsSkippingLine;
+
+	QVector<TelemetrySample> mSamples;
+	int mMaxSamples;
+
+	/// keys are shared by samples, so a sample of known key does not allocate a string
+	QHash<QByteArray, QByteArray> mKeys;
+
+	quint64 mLines;
+	quint64 mInvalidLines;
+	quint64 mDroppedSamples;
+};
@@ -0,0 +1,247 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+/* Latency benchmark of automation socket of gamepad. Benchmark plays the robot: it listens gamepad port, and
+ * gamepad should be started with --automation and connected to it, e.g.
+ *   automationBenchmark --socket /tmp/gamepad.sock --port 4445 &
+ *   trikDesktopGamepad --automation /tmp/gamepad.sock 127.0.0.1 4445
+ * Round trip of "ping" and "status" requests, time until pad command is replied with "ok" and time until it
+ * reaches the robot side are measured and printed as JSON.
+ *
+ * Usage: automationBenchmark --socket path [--port 4444] [--count 1000] [--timeout seconds] [--output file] */
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QThread>
+#include <QtNetwork/QLocalSocket>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "commandProtocol.h"
+
+namespace {
+
+/// one request should never take that long, benchmark fails if it does
+const int requestTimeoutMs = 5000;
+
+qint64 timestamp()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/// reads one line without '\n', empty result means timeout or closed connection
+QByteArray readLine(QIODevice &device, int timeoutMs)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (!device.canReadLine()) {
+		const int remainingMs = timeoutMs - static_cast<int>(timer.elapsed());
+		if (remainingMs <= 0 || !device.waitForReadyRead(remainingMs)) {
+			return QByteArray();
+		}
+	}
+
+	return device.readLine().trimmed();
+}
+
+QJsonObject toJson(std::vector<qint64> latencies)
+{
+	QJsonObject result;
+	if (latencies.empty()) {
+		return result;
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+	result.insert("medianUs", latencies.at(latencies.size() / 2) / 1e3);
+	result.insert("p99Us", latencies.at(latencies.size() * 99 / 100) / 1e3);
+	result.insert("maxUs", latencies.back() / 1e3);
+	return result;
+}
+
+/// round trip of a request that is replied with given prefix
+bool measureRequest(QLocalSocket &automation, const QByteArray &request, const QByteArray &reply, int count
+		, std::vector<qint64> &latencies)
+{
+	for (int i = 0; i < count; ++i) {
+		const qint64 start = timestamp();
+		automation.write(request + '\n');
+		automation.flush();
+		if (!readLine(automation, requestTimeoutMs).startsWith(reply)) {
+			fprintf(stderr, "No reply to %s\n", request.constData());
+			return false;
+		}
+
+		latencies.push_back(timestamp() - start);
+	}
+
+	return true;
+}
+
+QByteArray padCommand(int i)
+{
+	// neighbouring commands always differ, so none of them is taken for a repetition
+	return "pad 1 " + QByteArray::number(i % 200 - 100) + ' ' + QByteArray::number(i / 200 % 200 - 100);
+}
+
+/// time from request until robot receives the command, reply of gamepad is read afterwards
+bool measureEndToEnd(QLocalSocket &automation, QTcpSocket &robot, int first, int count
+		, std::vector<qint64> &latencies)
+{
+	for (int i = first; i < first + count; ++i) {
+		const QByteArray request = padCommand(i);
+		const GamepadCommand expected = GamepadCommand::parse(request);
+		const qint64 start = timestamp();
+		automation.write(request + '\n');
+		automation.flush();
+
+		// commands that gamepad sends on its own, e.g. from keyboard, are skipped
+		bool isReceived = false;
+		while (!isReceived) {
+			const QByteArray line = readLine(robot, requestTimeoutMs);
+			if (line.isEmpty()) {
+				fprintf(stderr, "Robot did not receive %s\n", request.constData());
+				return false;
+			}
+
+			const GamepadCommand command = GamepadCommand::parse(line);
+			isReceived = command.type == expected.type && command.id == expected.id
+					&& command.x == expected.x && command.y == expected.y;
+		}
+
+		latencies.push_back(timestamp() - start);
+		if (readLine(automation, requestTimeoutMs) != "ok") {
+			fprintf(stderr, "Gamepad did not accept %s\n", request.constData());
+			return false;
+		}
+	}
+
+	return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication application(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	const QCommandLineOption socketOption("socket", "Automation socket of gamepad.", "path");
+	const QCommandLineOption portOption("port", "Gamepad port to listen as robot, 4444 by default.", "port", "4444");
+	const QCommandLineOption countOption("count", "Requests of every kind, 1000 by default.", "count", "1000");
+	const QCommandLineOption timeoutOption("timeout", "How long to wait for gamepad, 60 s by default."
+			, "seconds", "60");
+	const QCommandLineOption outputOption("output", "File to write results to, stdout by default.", "file");
+	parser.addOptions({socketOption, portOption, countOption, timeoutOption, outputOption});
+	parser.process(application);
+
+	if (!parser.isSet(socketOption)) {
+		fprintf(stderr, "Automation socket is required\n");
+		return 1;
+	}
+
+	QTcpServer server;
+	if (!server.listen(QHostAddress::Any, static_cast<quint16>(parser.value(portOption).toUInt()))) {
+		fprintf(stderr, "Can not listen gamepad port: %s\n", qPrintable(server.errorString()));
+		return 1;
+	}
+
+	fprintf(stderr, "Waiting for gamepad with automation socket %s connected to port %d\n"
+			, qPrintable(parser.value(socketOption)), server.serverPort());
+
+	QElapsedTimer waiting;
+	waiting.start();
+	const qint64 timeoutMs = parser.value(timeoutOption).toLongLong() * 1000;
+	QLocalSocket automation;
+	for (;;) {
+		automation.connectToServer(parser.value(socketOption));
+		if (automation.waitForConnected(100)) {
+			break;
+		}
+
+		if (waiting.elapsed() > timeoutMs) {
+			fprintf(stderr, "Can not connect to automation socket: %s\n", qPrintable(automation.errorString()));
+			return 1;
+		}
+
+		automation.abort();
+		QThread::msleep(100);
+	}
+
+	const int remainingMs = static_cast<int>(qMax<qint64>(0, timeoutMs - waiting.elapsed()));
+	if (!server.hasPendingConnections() && !server.waitForNewConnection(remainingMs)) {
+		fprintf(stderr, "Gamepad did not connect to port %d\n", server.serverPort());
+		return 1;
+	}
+
+	QTcpSocket *robot = server.nextPendingConnection();
+	robot->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+	// held state that gamepad resends after connection is not measured
+	while (robot->waitForReadyRead(200)) {
+		robot->readAll();
+	}
+
+	const int count = qMax(1, parser.value(countOption).toInt());
+	std::vector<qint64> ping;
+	std::vector<qint64> status;
+	std::vector<qint64> ack;
+	std::vector<qint64> endToEnd;
+	bool isOk = measureRequest(automation, "ping", "pong", count, ping)
+			&& measureRequest(automation, "status", "{", count, status);
+	for (int i = 0; isOk && i < count; ++i) {
+		isOk = measureRequest(automation, padCommand(i), "ok", 1, ack);
+	}
+
+	// commands of the previous phase that are still on their way do not match the next ones
+	robot->readAll();
+	isOk = isOk && measureEndToEnd(automation, *robot, count, count, endToEnd);
+
+	automation.write("pad 1 up\n");
+	automation.flush();
+	readLine(automation, requestTimeoutMs);
+	if (!isOk) {
+		return 1;
+	}
+
+	QJsonObject results;
+	results.insert("ping", toJson(ping));
+	results.insert("status", toJson(status));
+	results.insert("ack", toJson(ack));
+	results.insert("endToEnd", toJson(endToEnd));
+	const QByteArray json = QJsonDocument(results).toJson();
+	if (parser.isSet(outputOption)) {
+		QFile file(parser.value(outputOption));
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+			fprintf(stderr, "Can not write results to %s\n", qPrintable(parser.value(outputOption)));
+			return 1;
+		}
+	} else {
+		fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+	}
+
+	return 0;
+}
@@ -0,0 +1,50 @@
+# Copyright 2017 Konstantin Batoev.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+include(../tools.pri)
+
+QT += core gui network
+
+TARGET = benchmarks
+
+SOURCES += main.cpp \
+        $$GAMEPAD_DIR/strategy.cpp \
+        $$GAMEPAD_DIR/standardStrategy.cpp \
+        $$GAMEPAD_DIR/accelerateStrategy.cpp \
+        $$GAMEPAD_DIR/connectionManager.cpp \
+        $$GAMEPAD_DIR/commandProtocol.cpp \
+        $$GAMEPAD_DIR/tracer.cpp \
+        $$GAMEPAD_DIR/commandJournal.cpp \
+        $$GAMEPAD_DIR/metrics.cpp \
+        $$GAMEPAD_DIR/commandScheduler.cpp \
+        $$GAMEPAD_DIR/deadManWatchdog.cpp \
+        $$GAMEPAD_DIR/gamepadState.cpp \
+        $$GAMEPAD_DIR/telemetryReader.cpp \
+        $$GAMEPAD_DIR/plotSeries.cpp
+
+HEADERS += \
+        $$GAMEPAD_DIR/strategy.h \
+        $$GAMEPAD_DIR/standardStrategy.h \
+        $$GAMEPAD_DIR/accelerateStrategy.h \
+        $$GAMEPAD_DIR/connectionManager.h \
+        $$GAMEPAD_DIR/commandProtocol.h \
+        $$GAMEPAD_DIR/tracer.h \
+        $$GAMEPAD_DIR/commandJournalFormat.h \
+        $$GAMEPAD_DIR/commandJournal.h \
+        $$GAMEPAD_DIR/metrics.h \
+        $$GAMEPAD_DIR/commandScheduler.h \
+        $$GAMEPAD_DIR/deadManWatchdog.h \
+        $$GAMEPAD_DIR/gamepadState.h \
+        $$GAMEPAD_DIR/telemetryReader.h \
+        $$GAMEPAD_DIR/plotSeries.h
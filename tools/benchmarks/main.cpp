@@ -0,0 +1,440 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+/* Benchmarks of gamepad core: command formatting, strategies, passing commands to connection thread,
+ * decoding of video frames, sending commands through loopback connection and decimation of plots.
+ * Results are printed as JSON, so they can be stored and compared with later runs: with --baseline
+ * every result is compared with the stored one, exit code is 3 if some of them is worse than tolerance allows.
+ *
+ * Usage: benchmarks [--filter group] [--output file] [--baseline file] [--tolerance percent] */
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QFile>
+#include <QtCore/QBuffer>
+#include <QtCore/QThread>
+#include <QtGui/QImage>
+#include <QtGui/QImageReader>
+#include <QtGui/QKeyEvent>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "strategy.h"
+#include "connectionManager.h"
+#include "commandProtocol.h"
+#include "plotSeries.h"
+
+namespace {
+
+struct Result
+{
+	QString name;
+	double value;
+	QString unit;
+	bool isHigherBetter;
+};
+
+qint64 timestamp()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/// average time of one call of body in nanoseconds, body is warmed up first
+template <typename Body>
+double measureNs(int iterations, Body body)
+{
+	for (int i = 0; i < iterations / 10; ++i) {
+		body(i);
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < iterations; ++i) {
+		body(i);
+	}
+
+	return static_cast<double>(timer.nsecsElapsed()) / iterations;
+}
+
+void benchmarkFormatting(QVector<Result> &results)
+{
+	const int iterations = 200000;
+	int size = 0;
+
+	// the same formatting as in StandardStrategy
+	results.append({"formatting.pad", measureNs(iterations, [&size](int i) {
+		size += QString("pad 1 %1 %2 \n").arg(i % 201 - 100).arg(100 - i % 201).size();
+	}), "ns", false});
+
+	results.append({"formatting.btn", measureNs(iterations, [&size](int i) {
+		size += QString("btn " + QString::number(i % 5 + 1) + "\n").size();
+	}), "ns", false});
+
+	// conversion that ConnectionManager::write() does before sending
+	const QString command = "pad 1 -100 100 \n";
+	results.append({"formatting.toLatin1", measureNs(iterations, [&size, &command](int) {
+		size += command.toLatin1().size();
+	}), "ns", false});
+
+	results.append({"formatting.parse", measureNs(iterations, [&size](int i) {
+		size += GamepadCommand::parse(i % 2 ? "pad 1 -100 100" : "btn 3").id;
+	}), "ns", false});
+
+	if (size == 0) {
+		fprintf(stderr, "Formatting produced nothing\n");
+	}
+}
+
+void benchmarkStrategies(QVector<Result> &results)
+{
+	const QVector<int> keys = {Qt::Key_W, Qt::Key_D, Qt::Key_Up, Qt::Key_Left, Qt::Key_1, Qt::Key_S, Qt::Key_A};
+	const QList<QPair<Strategies, QString>> types = {
+		{standartStrategy, "standard"}
+		, {accelerateStrategy, "accelerate"}
+	};
+
+	for (const auto &type : types) {
+		Strategy *strategy = Strategy::getStrategy(type.first);
+		int commands = 0;
+		const QMetaObject::Connection connection = QObject::connect(strategy, &Strategy::commandPrepared
+				, [&commands](const QString &) { ++commands; });
+
+		const int iterations = 100000;
+		const double eventNs = measureNs(iterations, [&keys, strategy](int i) {
+			const int key = keys.at(i / 2 % keys.size());
+			QKeyEvent event(i % 2 ? QEvent::KeyRelease : QEvent::KeyPress, key, Qt::NoModifier);
+			strategy->processEvent(&event);
+		});
+
+		QObject::disconnect(connection);
+		strategy->reset();
+		results.append({"strategy." + type.second + ".event", eventNs, "ns", false});
+		results.append({"strategy." + type.second + ".eventsPerSecond", 1e9 / eventNs, "1/s", true});
+	}
+}
+
+QByteArray createJpeg(int width, int height)
+{
+	QImage image(width, height, QImage::Format_RGB32);
+	for (int y = 0; y < height; ++y) {
+		QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+		for (int x = 0; x < width; ++x) {
+			line[x] = qRgb(x & 0xff, y & 0xff, (x * y) & 0xff);
+		}
+	}
+
+	QBuffer buffer;
+	buffer.open(QIODevice::WriteOnly);
+	image.save(&buffer, "JPG", 80);
+	return buffer.data();
+}
+
+void benchmarkJpeg(QVector<Result> &results)
+{
+	const int width = 640;
+	const int height = 480;
+	const QByteArray jpeg = createJpeg(width, height);
+	const double megapixels = width * height / 1e6;
+
+	// the same decoding as in VideoDecoder, reduced sizes are decoded by libjpeg directly
+	for (const int denominator : {1, 2, 4}) {
+		const double decodeNs = measureNs(200, [&jpeg, denominator, width, height](int) {
+			QBuffer buffer;
+			buffer.setData(jpeg);
+			buffer.open(QIODevice::ReadOnly);
+			QImageReader reader(&buffer, "JPG");
+			if (denominator > 1) {
+				reader.setScaledSize(QSize(width / denominator, height / denominator));
+			}
+
+			reader.read();
+		});
+
+		const QString name = "jpeg.decode1/" + QString::number(denominator);
+		results.append({name, decodeNs / 1e6, "ms", false});
+		results.append({name + ".megapixelsPerSecond", megapixels * 1e9 / decodeNs, "MP/s", true});
+	}
+}
+
+/// connection manager in its own thread, connected to a listener in this thread, like in gamepad
+class LoopbackConnection
+{
+public:
+	LoopbackConnection()
+		: mPeer(nullptr)
+	{
+		mServer.listen(QHostAddress::LocalHost, 0);
+		mManager.setGamepadIp("127.0.0.1");
+		mManager.setGamepadPort(mServer.serverPort());
+		mManager.moveToThread(&mThread);
+		mThread.start();
+		QMetaObject::invokeMethod(&mManager, "connectToHost", Qt::QueuedConnection);
+		if (mServer.waitForNewConnection(3000)) {
+			mPeer = mServer.nextPendingConnection();
+		}
+
+		// manager drops commands until it handles its own connection
+		QElapsedTimer timer;
+		timer.start();
+		while (mPeer && !mManager.isConnected() && timer.elapsed() < 3000) {
+			QThread::yieldCurrentThread();
+		}
+	}
+
+	~LoopbackConnection()
+	{
+		QMetaObject::invokeMethod(&mManager, "disconnectFromHost", Qt::BlockingQueuedConnection);
+		mThread.quit();
+		mThread.wait();
+	}
+
+	bool isConnected() const
+	{
+		return mPeer != nullptr;
+	}
+
+	ConnectionManager &manager()
+	{
+		return mManager;
+	}
+
+	/// reads given amount of data that came to listener
+	bool receive(qint64 bytes)
+	{
+		qint64 received = 0;
+		while (received < bytes) {
+			if (mPeer->bytesAvailable() == 0 && !mPeer->waitForReadyRead(3000)) {
+				return false;
+			}
+
+			received += mPeer->readAll().size();
+		}
+
+		return true;
+	}
+
+	void drain()
+	{
+		mPeer->waitForReadyRead(0);
+		mPeer->readAll();
+	}
+
+private:
+	QTcpServer mServer;
+	QTcpSocket *mPeer;
+	ConnectionManager mManager;
+	QThread mThread;
+};
+
+void benchmarkDispatch(QVector<Result> &results)
+{
+	LoopbackConnection connection;
+	if (!connection.isConnected()) {
+		fprintf(stderr, "Loopback connection is not established, dispatch is not measured\n");
+		return;
+	}
+
+	// time of write is taken in connection thread right when ConnectionManager::write() is done
+	std::atomic<qint64> writtenAt(0);
+	QObject::connect(&connection.manager(), &ConnectionManager::dataWasWritten, [&writtenAt](int) {
+		writtenAt = timestamp();
+	});
+
+	const int iterations = 10000;
+	std::vector<qint64> latencies;
+	latencies.reserve(iterations);
+	const QString command = "pad 1 50 -50 \n";
+	for (int i = 0; i < iterations; ++i) {
+		writtenAt = 0;
+		// the same path through scheduler as GamepadForm::sendCommand takes
+		const qint64 sentAt = timestamp();
+		connection.manager().send(command);
+		while (writtenAt == 0) {
+		}
+
+		latencies.push_back(writtenAt - sentAt);
+		if (i % 1000 == 0) {
+			connection.drain();
+		}
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+	double sum = 0;
+	for (const qint64 latency : latencies) {
+		sum += latency;
+	}
+
+	results.append({"dispatch.average", sum / iterations / 1e3, "us", false});
+	results.append({"dispatch.median", latencies.at(iterations / 2) / 1e3, "us", false});
+	results.append({"dispatch.p99", latencies.at(iterations * 99 / 100) / 1e3, "us", false});
+}
+
+void benchmarkThroughput(QVector<Result> &results)
+{
+	LoopbackConnection connection;
+	if (!connection.isConnected()) {
+		fprintf(stderr, "Loopback connection is not established, throughput is not measured\n");
+		return;
+	}
+
+	const int commands = 100000;
+	const QString command = "pad 2 -100 100 \n";
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < commands; ++i) {
+		QMetaObject::invokeMethod(&connection.manager(), "write", Qt::QueuedConnection, Q_ARG(QString, command));
+	}
+
+	if (!connection.receive(static_cast<qint64>(commands) * command.size())) {
+		fprintf(stderr, "Not all commands are received\n");
+		return;
+	}
+
+	const double seconds = timer.nsecsElapsed() / 1e9;
+	results.append({"throughput.commandsPerSecond", commands / seconds, "1/s", true});
+	results.append({"throughput.megabytesPerSecond", commands * command.size() / seconds / 1e6, "MB/s", true});
+}
+
+/// appending to a full series of telemetry and decimating windows of different length to a plot of 1000 columns
+void benchmarkPlot(QVector<Result> &results)
+{
+	// a series of 1 kHz that is full, as after several minutes of telemetry
+	PlotSeries series;
+	const qint64 periodNs = 1000000;
+	qint64 sample = 0;
+	results.append({"plot.append", measureNs(series.capacity(), [&series, &sample, periodNs](int) {
+		series.append(sample * periodNs, sample % 1000);
+		++sample;
+	}), "ns", false});
+
+	const qint64 endNs = series.lastTimestamp();
+	QVector<PlotSeries::Column> columns(1000);
+	for (const int seconds : {1, 10, 60, 240}) {
+		results.append({QString("plot.decimate%1s").arg(seconds), measureNs(1000
+				, [&series, &columns, endNs, seconds](int) {
+			series.decimate(endNs - seconds * 1000000000LL, endNs, columns);
+		}), "ns", false});
+	}
+}
+
+QJsonObject toJson(const QVector<Result> &results)
+{
+	QJsonObject object;
+	for (const Result &result : results) {
+		QJsonObject value;
+		value.insert("value", result.value);
+		value.insert("unit", result.unit);
+		value.insert("higherIsBetter", result.isHigherBetter);
+		object.insert(result.name, value);
+	}
+
+	QJsonObject json;
+	json.insert("results", object);
+	return json;
+}
+
+/// prints comparison with baseline to stderr, returns number of results that got worse more than tolerance
+int compare(const QVector<Result> &results, const QJsonObject &baseline, double tolerancePercent)
+{
+	int regressions = 0;
+	const QJsonObject baselineResults = baseline.value("results").toObject();
+	for (const Result &result : results) {
+		const double old = baselineResults.value(result.name).toObject().value("value").toDouble();
+		if (old <= 0) {
+			fprintf(stderr, "%-40s %12.3f %-5s (no baseline)\n", qPrintable(result.name), result.value
+					, qPrintable(result.unit));
+			continue;
+		}
+
+		const double changePercent = (result.value - old) / old * 100;
+		const bool isWorse = result.isHigherBetter ? -changePercent > tolerancePercent : changePercent > tolerancePercent;
+		regressions += isWorse ? 1 : 0;
+		fprintf(stderr, "%-40s %12.3f %-5s %+7.1f%%%s\n", qPrintable(result.name), result.value
+				, qPrintable(result.unit), changePercent, isWorse ? "  REGRESSION" : "");
+	}
+
+	return regressions;
+}
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication application(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	const QCommandLineOption filterOption("filter"
+			, "Run only given group: formatting, strategy, dispatch, jpeg, throughput or plot.", "group");
+	const QCommandLineOption outputOption("output", "File to write results to, stdout by default.", "file");
+	const QCommandLineOption baselineOption("baseline", "Results of previous run to compare with.", "file");
+	const QCommandLineOption toleranceOption("tolerance", "Allowed worsening, 10% by default.", "percent", "10");
+	parser.addOptions({filterOption, outputOption, baselineOption, toleranceOption});
+	parser.process(application);
+
+	const QList<QPair<QString, void (*)(QVector<Result> &)>> groups = {
+		{"formatting", benchmarkFormatting}
+		, {"strategy", benchmarkStrategies}
+		, {"dispatch", benchmarkDispatch}
+		, {"jpeg", benchmarkJpeg}
+		, {"throughput", benchmarkThroughput}
+		, {"plot", benchmarkPlot}
+	};
+
+	QVector<Result> results;
+	for (const auto &group : groups) {
+		if (!parser.isSet(filterOption) || parser.value(filterOption) == group.first) {
+			fprintf(stderr, "Running %s benchmarks\n", qPrintable(group.first));
+			group.second(results);
+		}
+	}
+
+	const QByteArray json = QJsonDocument(toJson(results)).toJson();
+	if (parser.isSet(outputOption)) {
+		QFile file(parser.value(outputOption));
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+			fprintf(stderr, "Can not write results to %s\n", qPrintable(parser.value(outputOption)));
+			return 1;
+		}
+	} else {
+		fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+	}
+
+	if (parser.isSet(baselineOption)) {
+		QFile file(parser.value(baselineOption));
+		if (!file.open(QIODevice::ReadOnly)) {
+			fprintf(stderr, "Can not open baseline %s\n", qPrintable(parser.value(baselineOption)));
+			return 1;
+		}
+
+		const QJsonObject baseline = QJsonDocument::fromJson(file.readAll()).object();
+		if (compare(results, baseline, parser.value(toleranceOption).toDouble()) > 0) {
+			return 3;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,50 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "quitOnSignals.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QSocketNotifier>
+
+#include <csignal>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+int signalSockets[2];
+
+void handleSignal(int)
+{
+	const char byte = 1;
+	const ssize_t written = ::write(signalSockets[0], &byte, sizeof(byte));
+	Q_UNUSED(written)
+}
+}
+
+bool quitOnSignals(QCoreApplication &application)
+{
+	if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalSockets) != 0) {
+		return false;
+	}
+
+	QSocketNotifier *notifier = new QSocketNotifier(signalSockets[1], QSocketNotifier::Read, &application);
+	QObject::connect(notifier, &QSocketNotifier::activated, &application, &QCoreApplication::quit);
+	std::signal(SIGINT, handleSignal);
+	std::signal(SIGTERM, handleSignal);
+	return true;
+}
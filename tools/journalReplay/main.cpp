@@ -0,0 +1,231 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+/* Replays command journal written by gamepad with --journal option to a robot or to mockRobot.
+ * Commands are sent with their original intervals, divided by --speed. Every command is sent at its moment
+ * by sleeping until shortly before it and spinning the rest of time; difference between planned and actual
+ * sending time is reported as scheduling error in JSON.
+ *
+ * Usage: journalReplay <journal> [--host 127.0.0.1] [--port 4444] [--speed 1] [--dry-run] [--print]
+ *         [--report file] */
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtNetwork/QTcpSocket>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <vector>
+
+#include <time.h>
+
+#include "commandJournalFormat.h"
+
+using namespace commandJournal;
+
+namespace {
+
+/// the last part of waiting is done by spinning, as sleep is not precise enough
+const qint64 spinNs = 200 * 1000;
+
+qint64 monotonicNs()
+{
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return static_cast<qint64>(time.tv_sec) * 1000000000LL + time.tv_nsec;
+}
+
+void waitUntil(qint64 targetNs)
+{
+	const qint64 sleepUntil = targetNs - spinNs;
+	if (sleepUntil > monotonicNs()) {
+		timespec time;
+		time.tv_sec = static_cast<time_t>(sleepUntil / 1000000000LL);
+		time.tv_nsec = static_cast<long>(sleepUntil % 1000000000LL);
+		// error is returned, not put to errno; on errors other than signals the rest of time is spun
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR) {
+		}
+	}
+
+	while (monotonicNs() < targetNs) {
+	}
+}
+
+bool readJournal(const QString &fileName, JournalHeader &header, std::vector<JournalRecord> &records)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) {
+		fprintf(stderr, "Can not open %s: %s\n", qPrintable(fileName), qPrintable(file.errorString()));
+		return false;
+	}
+
+	const qint64 headerSize = static_cast<qint64>(sizeof(header));
+	if (file.read(reinterpret_cast<char *>(&header), headerSize) != headerSize || header.magic != magic
+			|| header.version != version || header.recordSize != sizeof(JournalRecord)) {
+		fprintf(stderr, "%s is not a command journal of supported version\n", qPrintable(fileName));
+		return false;
+	}
+
+	// header can grow in later versions, but not shrink, and records follow it; record size is checked above
+	if (header.headerSize < headerSize || header.headerSize > file.size()) {
+		fprintf(stderr, "%s has wrong size of header: %u\n", qPrintable(fileName), header.headerSize);
+		return false;
+	}
+
+	file.seek(header.headerSize);
+	// the last record of a journal that was not closed properly may be incomplete, it is ignored
+	records.resize(static_cast<size_t>((file.size() - header.headerSize) / header.recordSize));
+	const qint64 size = static_cast<qint64>(records.size() * sizeof(JournalRecord));
+	return file.read(reinterpret_cast<char *>(records.data()), size) == size;
+}
+
+void printJournal(const JournalHeader &header, const std::vector<JournalRecord> &records)
+{
+	const QDateTime start = QDateTime::fromMSecsSinceEpoch(header.startWallClockMs);
+	printf("Journal started at %s\n", qPrintable(start.toString(Qt::ISODateWithMs)));
+	for (const JournalRecord &record : records) {
+		const QByteArray command(record.command, record.size);
+		printf("%12.3f ms  %s%s\n", (record.timestampNs - header.startTimestampNs) / 1e6
+				, command.trimmed().constData(), record.isTruncated ? " (truncated)" : "");
+	}
+}
+
+double percentileUs(std::vector<qint64> values, double fraction)
+{
+	if (values.empty()) {
+		return 0;
+	}
+
+	const size_t index = std::min(values.size() - 1, static_cast<size_t>(values.size() * fraction));
+	std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+	return values[index] / 1e3;
+}
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication application(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	parser.addPositionalArgument("journal", "Journal written by gamepad with --journal option.");
+	const QCommandLineOption hostOption("host", "Address of robot, 127.0.0.1 by default.", "host", "127.0.0.1");
+	const QCommandLineOption portOption("port", "Gamepad port of robot, 4444 by default.", "port", "4444");
+	const QCommandLineOption speedOption("speed", "Replay so many times faster, 1 by default.", "factor", "1");
+	const QCommandLineOption dryRunOption("dry-run", "Do not connect, only measure scheduling.");
+	const QCommandLineOption printOption("print", "Print journal as text and exit.");
+	const QCommandLineOption reportOption("report", "File to write report to, stdout by default.", "file");
+	parser.addOptions({hostOption, portOption, speedOption, dryRunOption, printOption, reportOption});
+	parser.process(application);
+
+	if (parser.positionalArguments().size() != 1) {
+		parser.showHelp(1);
+	}
+
+	JournalHeader header;
+	std::vector<JournalRecord> records;
+	if (!readJournal(parser.positionalArguments().first(), header, records)) {
+		return 1;
+	}
+
+	if (parser.isSet(printOption)) {
+		printJournal(header, records);
+		return 0;
+	}
+
+	const double speed = parser.value(speedOption).toDouble();
+	if (speed <= 0) {
+		fprintf(stderr, "Speed should be positive\n");
+		return 1;
+	}
+
+	QTcpSocket socket;
+	const bool isDryRun = parser.isSet(dryRunOption);
+	if (!isDryRun) {
+		socket.connectToHost(parser.value(hostOption), static_cast<quint16>(parser.value(portOption).toUInt()));
+		if (!socket.waitForConnected(3000)) {
+			fprintf(stderr, "Can not connect: %s\n", qPrintable(socket.errorString()));
+			return 1;
+		}
+
+		socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+	}
+
+	std::vector<qint64> errors;
+	errors.reserve(records.size());
+	int truncated = 0;
+	const qint64 firstRecordNs = records.empty() ? 0 : records.front().timestampNs;
+	const qint64 startNs = monotonicNs();
+	for (const JournalRecord &record : records) {
+		const qint64 targetNs = startNs + static_cast<qint64>((record.timestampNs - firstRecordNs) / speed);
+		waitUntil(targetNs);
+		const qint64 sentNs = monotonicNs();
+		if (!isDryRun) {
+			socket.write(record.command, record.size);
+			socket.flush();
+		}
+
+		errors.push_back(sentNs - targetNs);
+		truncated += record.isTruncated;
+	}
+
+	const qint64 replayNs = monotonicNs() - startNs;
+	if (!isDryRun) {
+		socket.disconnectFromHost();
+		if (socket.state() != QAbstractSocket::UnconnectedState) {
+			socket.waitForDisconnected(3000);
+		}
+	}
+
+	double sum = 0;
+	for (const qint64 error : errors) {
+		sum += error;
+	}
+
+	const qint64 journalNs = records.empty() ? 0 : records.back().timestampNs - firstRecordNs;
+	QJsonObject schedulingError;
+	schedulingError.insert("averageUs", errors.empty() ? 0.0 : sum / errors.size() / 1e3);
+	schedulingError.insert("medianUs", percentileUs(errors, 0.5));
+	schedulingError.insert("p99Us", percentileUs(errors, 0.99));
+	schedulingError.insert("maxUs", percentileUs(errors, 1));
+
+	QJsonObject report;
+	report.insert("commands", static_cast<int>(records.size()));
+	report.insert("truncatedCommands", truncated);
+	report.insert("speed", speed);
+	report.insert("journalDurationMs", journalNs / 1e6);
+	report.insert("replayDurationMs", replayNs / 1e6);
+	report.insert("schedulingError", schedulingError);
+
+	const QByteArray json = QJsonDocument(report).toJson();
+	if (parser.isSet(reportOption)) {
+		QFile file(parser.value(reportOption));
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+			fprintf(stderr, "Can not write report to %s\n", qPrintable(parser.value(reportOption)));
+			return 1;
+		}
+	} else {
+		fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+	}
+
+	return 0;
+}
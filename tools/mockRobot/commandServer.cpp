@@ -0,0 +1,205 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "commandServer.h"
+
+#include <QTcpSocket>
+#include <QFile>
+#include <QJsonArray>
+
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+
+namespace {
+/// so many invalid lines are kept in statistics as examples
+const int invalidExamplesCount = 10;
+
+/// line without '\n' longer than this is not a command, buffer is dropped
+const int maxLineLength = 1024;
+}
+
+CommandServer::CommandServer(QObject *parent)
+	: QObject(parent)
+	, mConnections(0)
+	, mLogFile(nullptr)
+{
+	connect(&mServer, SIGNAL(newConnection()), this, SLOT(acceptConnections()));
+}
+
+bool CommandServer::listen(quint16 port)
+{
+	return mServer.listen(QHostAddress::Any, port);
+}
+
+QString CommandServer::errorString() const
+{
+	return mServer.errorString();
+}
+
+bool CommandServer::setLogFile(const QString &fileName)
+{
+	mLogFile = new QFile(fileName, this);
+	return mLogFile->open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+const QVector<CommandServer::Record> &CommandServer::records() const
+{
+	return mRecords;
+}
+
+int CommandServer::connections() const
+{
+	return mConnections;
+}
+
+qint64 CommandServer::timestamp()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void CommandServer::acceptConnections()
+{
+	while (mServer.hasPendingConnections()) {
+		QTcpSocket *socket = mServer.nextPendingConnection();
+		// commands are small and should be seen as soon as they arrive
+		socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		mBuffers.insert(socket, QByteArray());
+		++mConnections;
+		connect(socket, SIGNAL(readyRead()), this, SLOT(readCommands()));
+		connect(socket, SIGNAL(disconnected()), this, SLOT(removeConnection()));
+		fprintf(stderr, "Gamepad connected from %s\n", qPrintable(socket->peerAddress().toString()));
+	}
+}
+
+void CommandServer::readCommands()
+{
+	QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+	if (!socket || !mBuffers.contains(socket)) {
+		return;
+	}
+
+	// all commands of one read have the same arrival time
+	const qint64 arrivalTime = timestamp();
+	QByteArray &buffer = mBuffers[socket];
+	buffer += socket->readAll();
+
+	int lineEnd = buffer.indexOf('\n');
+	while (lineEnd != -1) {
+		Record record;
+		record.timestampNs = arrivalTime;
+		record.line = buffer.left(lineEnd);
+		record.command = GamepadCommand::parse(record.line);
+		buffer.remove(0, lineEnd + 1);
+		mRecords.append(record);
+
+		if (mLogFile) {
+			mLogFile->write(QByteArray::number(arrivalTime) + '\t'
+					+ (record.command.isValid() ? "valid" : "invalid") + '\t' + record.line + '\n');
+		}
+
+		emit commandReceived(record.command, arrivalTime);
+		lineEnd = buffer.indexOf('\n');
+	}
+
+	if (buffer.size() > maxLineLength) {
+		Record record;
+		record.timestampNs = arrivalTime;
+		record.line = buffer.left(maxLineLength);
+		mRecords.append(record);
+		buffer.clear();
+	}
+}
+
+int CommandServer::send(const QByteArray &data)
+{
+	for (QTcpSocket *socket : mBuffers.keys()) {
+		socket->write(data);
+	}
+
+	return mBuffers.size();
+}
+
+void CommandServer::removeConnection()
+{
+	QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+	if (!socket) {
+		return;
+	}
+
+	mBuffers.remove(socket);
+	socket->deleteLater();
+	fprintf(stderr, "Gamepad disconnected\n");
+}
+
+QJsonObject CommandServer::statistics() const
+{
+	QHash<QString, int> counts;
+	QJsonArray invalidExamples;
+	qint64 minIntervalNs = 0;
+	qint64 maxIntervalNs = 0;
+	for (int i = 0; i < mRecords.size(); ++i) {
+		const Record &record = mRecords.at(i);
+		switch (record.command.type) {
+		case GamepadCommand::Type::pad:
+			++counts["pad"];
+			break;
+		case GamepadCommand::Type::padUp:
+			++counts["padUp"];
+			break;
+		case GamepadCommand::Type::button:
+			++counts["btn"];
+			break;
+		case GamepadCommand::Type::wheel:
+			++counts["wheel"];
+			break;
+		case GamepadCommand::Type::invalid:
+			++counts["invalid"];
+			if (invalidExamples.size() < invalidExamplesCount) {
+				invalidExamples.append(QString::fromLatin1(record.line));
+			}
+
+			break;
+		}
+
+		if (i > 0) {
+			const qint64 interval = record.timestampNs - mRecords.at(i - 1).timestampNs;
+			minIntervalNs = i == 1 ? interval : std::min(minIntervalNs, interval);
+			maxIntervalNs = std::max(maxIntervalNs, interval);
+		}
+	}
+
+	const qint64 durationNs = mRecords.size() > 1 ? mRecords.last().timestampNs - mRecords.first().timestampNs : 0;
+	QJsonObject types;
+	for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+		types.insert(it.key(), it.value());
+	}
+
+	QJsonObject result;
+	result.insert("connections", mConnections);
+	result.insert("commands", mRecords.size());
+	result.insert("invalidCommands", counts.value("invalid"));
+	result.insert("types", types);
+	result.insert("invalidExamples", invalidExamples);
+	result.insert("durationMs", durationNs / 1e6);
+	result.insert("commandsPerSecond", durationNs > 0 ? (mRecords.size() - 1) * 1e9 / durationNs : 0.0);
+	result.insert("minIntervalMs", minIntervalNs / 1e6);
+	result.insert("averageIntervalMs", mRecords.size() > 1 ? durationNs / 1e6 / (mRecords.size() - 1) : 0.0);
+	result.insert("maxIntervalMs", maxIntervalNs / 1e6);
+	return result;
+}
@@ -0,0 +1,78 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QTcpServer>
+#include <QHash>
+#include <QVector>
+#include <QJsonObject>
+
+#include "commandProtocol.h"
+
+class QFile;
+class QTcpSocket;
+
+/// Gamepad side of mock robot: accepts connections on gamepad port and records every received command
+/// with its arrival time (steady clock, the same as used by gamepad for its timestamps).
+class CommandServer : public QObject
+{
+	Q_OBJECT
+
+public:
+	struct Record
+	{
+		qint64 timestampNs;
+		QByteArray line;
+		GamepadCommand command;
+	};
+
+	explicit CommandServer(QObject *parent = nullptr);
+
+	bool listen(quint16 port);
+	QString errorString() const;
+
+	/// every command is written to given file as "<timestamp ns>\t<valid|invalid>\t<line>"
+	bool setLogFile(const QString &fileName);
+
+	const QVector<Record> &records() const;
+	int connections() const;
+
+	/// statistics of received commands
+	QJsonObject statistics() const;
+
+	/// writes data to every connected gamepad, returns number of gamepads
+	int send(const QByteArray &data);
+
+	static qint64 timestamp();
+
+signals:
+	void commandReceived(const GamepadCommand &command, qint64 timestampNs);
+
+private slots:
+	void acceptConnections();
+	void readCommands();
+	void removeConnection();
+
+private:
+	QTcpServer mServer;
+	QHash<QTcpSocket *, QByteArray> mBuffers;
+	QVector<Record> mRecords;
+	int mConnections;
+	QFile *mLogFile;
+};
@@ -0,0 +1,117 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+/* Mock of TRIK robot for tests and benchmarks without a robot.
+ * Listens gamepad port, records every command with its arrival time and checks it against protocol grammar,
+ * serves MJPEG stream of JPEG files from a directory on camera port and can send telemetry lines back to gamepad.
+ * Statistics are printed as JSON at exit
+ * (Ctrl+C or end of --duration).
+ *
+ * Usage: mockRobot [--gamepad-port 4444] [--camera-port 8080] [--frames dir] [--fps 30] [--log file]
+ *         [--telemetry-rate linesPerSecond] [--stats file] [--duration seconds]
+ * Exit code is 2 if some of received commands does not follow the protocol. */
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QFile>
+#include <QtCore/QTimer>
+
+#include <cstdio>
+
+#include "commandServer.h"
+#include "mjpegServer.h"
+#include "telemetrySender.h"
+#include "quitOnSignals.h"
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication application(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	const QCommandLineOption gamepadPortOption("gamepad-port", "Port of gamepad, 4444 by default.", "port", "4444");
+	const QCommandLineOption cameraPortOption("camera-port", "Port of camera, 8080 by default.", "port", "8080");
+	const QCommandLineOption framesOption("frames", "Directory with JPEG files, synthetic frames by default.", "dir");
+	const QCommandLineOption fpsOption("fps", "Frame rate of stream, 30 by default.", "fps", "30");
+	const QCommandLineOption logOption("log", "File to write every received command to.", "file");
+	const QCommandLineOption telemetryRateOption("telemetry-rate"
+			, "Telemetry lines sent to gamepad per second, none by default.", "linesPerSecond", "0");
+	const QCommandLineOption statsOption("stats", "File to write statistics to, stdout by default.", "file");
+	const QCommandLineOption durationOption("duration", "Stop after given number of seconds.", "seconds");
+	parser.addOptions({gamepadPortOption, cameraPortOption, framesOption, fpsOption, logOption
+			, telemetryRateOption, statsOption, durationOption});
+	parser.process(application);
+
+	CommandServer commandServer;
+	if (!commandServer.listen(static_cast<quint16>(parser.value(gamepadPortOption).toUInt()))) {
+		fprintf(stderr, "Can not listen gamepad port: %s\n", qPrintable(commandServer.errorString()));
+		return 1;
+	}
+
+	if (parser.isSet(logOption) && !commandServer.setLogFile(parser.value(logOption))) {
+		fprintf(stderr, "Can not open log file %s\n", qPrintable(parser.value(logOption)));
+		return 1;
+	}
+
+	TelemetrySender telemetrySender(commandServer);
+	telemetrySender.setRate(parser.value(telemetryRateOption).toInt());
+
+	MjpegServer mjpegServer;
+	if (!mjpegServer.loadFrames(parser.value(framesOption))) {
+		fprintf(stderr, "Can not read frames from %s\n", qPrintable(parser.value(framesOption)));
+		return 1;
+	}
+
+	mjpegServer.setFrameRate(parser.value(fpsOption).toInt());
+	if (!mjpegServer.listen(static_cast<quint16>(parser.value(cameraPortOption).toUInt()))) {
+		fprintf(stderr, "Can not listen camera port: %s\n", qPrintable(mjpegServer.errorString()));
+		return 1;
+	}
+
+	if (!quitOnSignals(application)) {
+		fprintf(stderr, "Can not set up signal handling\n");
+		return 1;
+	}
+
+	if (parser.isSet(durationOption)) {
+		QTimer::singleShot(parser.value(durationOption).toInt() * 1000, &application, &QCoreApplication::quit);
+	}
+
+	fprintf(stderr, "Mock robot is listening gamepad port %s and camera port %s\n"
+			, qPrintable(parser.value(gamepadPortOption)), qPrintable(parser.value(cameraPortOption)));
+	application.exec();
+
+	QJsonObject statistics;
+	statistics.insert("gamepad", commandServer.statistics());
+	statistics.insert("camera", mjpegServer.statistics());
+	statistics.insert("telemetry", telemetrySender.statistics());
+	const QByteArray json = QJsonDocument(statistics).toJson();
+	if (parser.isSet(statsOption)) {
+		QFile file(parser.value(statsOption));
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+			fprintf(stderr, "Can not write statistics to %s\n", qPrintable(parser.value(statsOption)));
+			return 1;
+		}
+	} else {
+		fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+	}
+
+	const QJsonObject gamepad = statistics.value("gamepad").toObject();
+	return gamepad.value("invalidCommands").toInt() == 0 ? 0 : 2;
+}
@@ -0,0 +1,225 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "mjpegServer.h"
+
+#include <QTcpSocket>
+#include <QDir>
+#include <QFile>
+#include <QBuffer>
+#include <QImage>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+const char boundary[] = "boundarydonotcross";
+
+/// frame is skipped for a client that has not received so much of previous frames yet
+const qint64 maxPendingBytes = 1024 * 1024;
+
+const int syntheticFramesCount = 30;
+const int syntheticFrameWidth = 640;
+const int syntheticFrameHeight = 480;
+}
+
+MjpegServer::MjpegServer(QObject *parent)
+	: QObject(parent)
+	, mCurrentFrame(0)
+	, mStreams(0)
+	, mSnapshots(0)
+	, mSentFrames(0)
+	, mSkippedFrames(0)
+	, mSentBytes(0)
+{
+	mFrameTimer.setTimerType(Qt::PreciseTimer);
+	setFrameRate(30);
+	connect(&mServer, SIGNAL(newConnection()), this, SLOT(acceptConnections()));
+	connect(&mFrameTimer, SIGNAL(timeout()), this, SLOT(sendFrames()));
+}
+
+bool MjpegServer::loadFrames(const QString &directory)
+{
+	mFrames.clear();
+	if (!directory.isEmpty()) {
+		const QDir dir(directory);
+		if (!dir.exists()) {
+			return false;
+		}
+
+		const QStringList files = dir.entryList({"*.jpg", "*.jpeg", "*.JPG", "*.JPEG"}, QDir::Files, QDir::Name);
+		for (const QString &fileName : files) {
+			QFile file(dir.filePath(fileName));
+			if (file.open(QIODevice::ReadOnly)) {
+				mFrames.append(file.readAll());
+			}
+		}
+	}
+
+	if (mFrames.isEmpty()) {
+		createSyntheticFrames();
+	}
+
+	return true;
+}
+
+void MjpegServer::setFrameRate(int fps)
+{
+	mFrameTimer.setInterval(1000 / std::max(1, fps));
+}
+
+bool MjpegServer::listen(quint16 port)
+{
+	return mServer.listen(QHostAddress::Any, port);
+}
+
+QString MjpegServer::errorString() const
+{
+	return mServer.errorString();
+}
+
+QJsonObject MjpegServer::statistics() const
+{
+	QJsonObject result;
+	result.insert("frames", mFrames.size());
+	result.insert("streams", mStreams);
+	result.insert("snapshots", mSnapshots);
+	result.insert("sentFrames", static_cast<double>(mSentFrames));
+	result.insert("skippedFrames", static_cast<double>(mSkippedFrames));
+	result.insert("sentBytes", static_cast<double>(mSentBytes));
+	return result;
+}
+
+void MjpegServer::acceptConnections()
+{
+	while (mServer.hasPendingConnections()) {
+		QTcpSocket *socket = mServer.nextPendingConnection();
+		mClients.insert(socket, {ClientState::request, QByteArray()});
+		connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+		connect(socket, SIGNAL(disconnected()), this, SLOT(removeConnection()));
+	}
+}
+
+void MjpegServer::readRequest()
+{
+	QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+	if (!socket || !mClients.contains(socket)) {
+		return;
+	}
+
+	Client &client = mClients[socket];
+	if (client.state != ClientState::request) {
+		socket->readAll();
+		return;
+	}
+
+	client.request += socket->readAll();
+	if (!client.request.contains("\r\n\r\n")) {
+		return;
+	}
+
+	const QByteArray requestLine = client.request.left(client.request.indexOf("\r\n"));
+	if (requestLine.contains("action=snapshot")) {
+		const QByteArray &frame = mFrames.at(mCurrentFrame);
+		client.state = ClientState::snapshot;
+		socket->write("HTTP/1.0 200 OK\r\nContent-Type: image/jpeg\r\nContent-Length: "
+				+ QByteArray::number(frame.size()) + "\r\nConnection: close\r\n\r\n");
+		socket->write(frame);
+		socket->disconnectFromHost();
+		++mSnapshots;
+		++mSentFrames;
+		mSentBytes += static_cast<quint64>(frame.size());
+		return;
+	}
+
+	client.state = ClientState::stream;
+	socket->write(QByteArray("HTTP/1.0 200 OK\r\nCache-Control: no-cache\r\n")
+			+ "Content-Type: multipart/x-mixed-replace;boundary=" + boundary + "\r\n\r\n");
+	++mStreams;
+	if (!mFrameTimer.isActive()) {
+		mFrameTimer.start();
+	}
+}
+
+void MjpegServer::removeConnection()
+{
+	QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+	if (!socket) {
+		return;
+	}
+
+	mClients.remove(socket);
+	socket->deleteLater();
+}
+
+void MjpegServer::sendFrames()
+{
+	mCurrentFrame = (mCurrentFrame + 1) % mFrames.size();
+	const QByteArray part = framePart(mFrames.at(mCurrentFrame));
+
+	bool hasStreams = false;
+	for (auto it = mClients.begin(); it != mClients.end(); ++it) {
+		if (it.value().state != ClientState::stream) {
+			continue;
+		}
+
+		hasStreams = true;
+		QTcpSocket *socket = it.key();
+		// slow client gets less frames instead of growing delay, as real camera does
+		if (socket->bytesToWrite() > maxPendingBytes) {
+			++mSkippedFrames;
+			continue;
+		}
+
+		socket->write(part);
+		++mSentFrames;
+		mSentBytes += static_cast<quint64>(part.size());
+	}
+
+	if (!hasStreams) {
+		mFrameTimer.stop();
+	}
+}
+
+void MjpegServer::createSyntheticFrames()
+{
+	for (int i = 0; i < syntheticFramesCount; ++i) {
+		QImage image(syntheticFrameWidth, syntheticFrameHeight, QImage::Format_RGB32);
+		const int shift = i * 256 / syntheticFramesCount;
+		for (int y = 0; y < image.height(); ++y) {
+			QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+			for (int x = 0; x < image.width(); ++x) {
+				line[x] = qRgb((x + shift) & 0xff, (y + shift) & 0xff, (x + y) & 0xff);
+			}
+		}
+
+		QBuffer buffer;
+		buffer.open(QIODevice::WriteOnly);
+		image.save(&buffer, "JPG", 80);
+		mFrames.append(buffer.data());
+	}
+}
+
+QByteArray MjpegServer::framePart(const QByteArray &frame) const
+{
+	using namespace std::chrono;
+	const qint64 now = duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+	return QByteArray("--") + boundary + "\r\nContent-Type: image/jpeg\r\nContent-Length: "
+			+ QByteArray::number(frame.size()) + "\r\nX-Timestamp: " + QByteArray::number(now / 1e6, 'f', 6)
+			+ "\r\n\r\n" + frame + "\r\n";
+}
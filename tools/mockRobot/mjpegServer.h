@@ -0,0 +1,83 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTimer>
+#include <QHash>
+#include <QVector>
+#include <QJsonObject>
+
+class QTcpSocket;
+
+/// Camera side of mock robot: serves JPEG files in the way mjpg-streamer does,
+/// "?action=stream" gives multipart stream and "?action=snapshot" gives one frame.
+class MjpegServer : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit MjpegServer(QObject *parent = nullptr);
+
+	/// frames are taken from *.jpg files of directory in alphabetical order, synthetic ones are used
+	/// if directory is empty
+	bool loadFrames(const QString &directory);
+
+	void setFrameRate(int fps);
+
+	bool listen(quint16 port);
+	QString errorString() const;
+
+	/// statistics of served frames
+	QJsonObject statistics() const;
+
+private slots:
+	void acceptConnections();
+	void readRequest();
+	void removeConnection();
+	void sendFrames();
+
+private:
+	enum class ClientState {
+		request
+		, stream
+		, snapshot
+	};
+
+	struct Client
+	{
+		ClientState state;
+		QByteArray request;
+	};
+
+	void createSyntheticFrames();
+	QByteArray framePart(const QByteArray &frame) const;
+
+	QTcpServer mServer;
+	QTimer mFrameTimer;
+	QVector<QByteArray> mFrames;
+	int mCurrentFrame;
+	QHash<QTcpSocket *, Client> mClients;
+
+	int mStreams;
+	int mSnapshots;
+	quint64 mSentFrames;
+	quint64 mSkippedFrames;
+	quint64 mSentBytes;
+};
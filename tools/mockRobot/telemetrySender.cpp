@@ -0,0 +1,101 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "telemetrySender.h"
+
+#include "commandServer.h"
+
+#include <cmath>
+
+namespace {
+/// lines are sent in batches, so high rates do not need a timer per line
+const int sendIntervalMs = 5;
+
+const char *const keys[] = {"sin", "cos", "saw", "counter"};
+const int keysCount = sizeof(keys) / sizeof(keys[0]);
+}
+
+TelemetrySender::TelemetrySender(CommandServer &server, QObject *parent)
+	: QObject(parent)
+	, mServer(server)
+	, mRate(0)
+	, mLines(0)
+	, mSentLines(0)
+	, mSentBytes(0)
+{
+	mTimer.setTimerType(Qt::PreciseTimer);
+	connect(&mTimer, SIGNAL(timeout()), this, SLOT(sendLines()));
+}
+
+void TelemetrySender::setRate(int linesPerSecond)
+{
+	mRate = qMax(0, linesPerSecond);
+	mLines = 0;
+	if (mRate == 0) {
+		mTimer.stop();
+		return;
+	}
+
+	mElapsed.start();
+	mTimer.start(sendIntervalMs);
+}
+
+QJsonObject TelemetrySender::statistics() const
+{
+	QJsonObject result;
+	result.insert("rate", mRate);
+	result.insert("sentLines", static_cast<double>(mSentLines));
+	result.insert("sentBytes", static_cast<double>(mSentBytes));
+	return result;
+}
+
+void TelemetrySender::sendLines()
+{
+	// rate is kept by elapsed time, so late timer ticks send more lines instead of lowering the rate
+	const qint64 elapsedNs = mElapsed.nsecsElapsed();
+	const qint64 target = elapsedNs * mRate / 1000000000;
+	QByteArray data;
+	for (; mLines < target; ++mLines) {
+		const double seconds = static_cast<double>(mLines) / mRate;
+		const int key = static_cast<int>(mLines % keysCount);
+		double value = 0;
+		switch (key) {
+		case 0:
+			value = 100 * std::sin(2 * M_PI * seconds);
+			break;
+		case 1:
+			value = 100 * std::cos(2 * M_PI * 0.5 * seconds);
+			break;
+		case 2:
+			value = std::fmod(seconds, 1.0) * 200 - 100;
+			break;
+		default:
+			value = static_cast<double>(mLines / keysCount);
+			break;
+		}
+
+		data += keys[key];
+		data += ' ';
+		data += QByteArray::number(value, 'g', 8);
+		data += '\n';
+	}
+
+	if (!data.isEmpty() && mServer.send(data) > 0) {
+		mSentLines += data.count('\n');
+		mSentBytes += data.size();
+	}
+}
@@ -0,0 +1,54 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+class CommandServer;
+
+/// Robot side of telemetry: sends "key value" lines to every connected gamepad at given rate, like a robot script
+/// that prints its sensors. Values are smooth curves and a counter, so gaps and reordering are easy to see.
+class TelemetrySender : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit TelemetrySender(CommandServer &server, QObject *parent = nullptr);
+
+	/// lines per second, 0 stops sending
+	void setRate(int linesPerSecond);
+
+	QJsonObject statistics() const;
+
+private slots:
+	void sendLines();
+
+private:
+	CommandServer &mServer;
+	QTimer mTimer;
+	QElapsedTimer mElapsed;
+	int mRate;
+
+	/// lines that should have been sent by now, including the ones without connected gamepad
+	qint64 mLines;
+	qint64 mSentLines;
+	qint64 mSentBytes;
+};
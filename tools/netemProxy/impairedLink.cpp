@@ -0,0 +1,164 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "impairedLink.h"
+
+#include <QTcpSocket>
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+/// like TCP window: source is not read while so much data is not delivered
+const qint64 receiveWindow = 64 * 1024;
+
+const qint64 nsInMs = 1000 * 1000;
+}
+
+Impairment Impairment::fromJson(const QJsonObject &object, const Impairment &defaults)
+{
+	Impairment result;
+	result.latencyMs = object.value("latency").toInt(defaults.latencyMs);
+	result.jitterMs = object.value("jitter").toInt(defaults.jitterMs);
+	result.bandwidthKbps = object.value("bandwidth").toInt(defaults.bandwidthKbps);
+	result.stallPeriodMs = object.value("stallPeriod").toInt(defaults.stallPeriodMs);
+	result.stallDurationMs = object.value("stallDuration").toInt(defaults.stallDurationMs);
+	return result;
+}
+
+QJsonObject Impairment::toJson() const
+{
+	QJsonObject result;
+	result.insert("latency", latencyMs);
+	result.insert("jitter", jitterMs);
+	result.insert("bandwidth", bandwidthKbps);
+	result.insert("stallPeriod", stallPeriodMs);
+	result.insert("stallDuration", stallDurationMs);
+	return result;
+}
+
+ImpairedLink::ImpairedLink(QTcpSocket *source, QTcpSocket *destination, QObject *parent)
+	: QObject(parent)
+	, mSource(source)
+	, mDestination(destination)
+	, mQueuedBytes(0)
+	, mMaxQueuedBytes(0)
+	, mLinkFreeTimeNs(0)
+	, mLastReleaseTimeNs(0)
+	, mRandom(std::random_device()())
+{
+	mSource->setReadBufferSize(receiveWindow);
+	mTimer.setSingleShot(true);
+	mTimer.setTimerType(Qt::PreciseTimer);
+	connect(&mTimer, SIGNAL(timeout()), this, SLOT(deliver()));
+	connect(mSource, SIGNAL(readyRead()), this, SLOT(readSource()));
+}
+
+void ImpairedLink::setImpairment(const Impairment &impairment)
+{
+	mImpairment = impairment;
+}
+
+qint64 ImpairedLink::takeMaxQueuedBytes()
+{
+	const qint64 result = mMaxQueuedBytes;
+	mMaxQueuedBytes = mQueuedBytes;
+	return result;
+}
+
+qint64 ImpairedLink::timestamp()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void ImpairedLink::readSource()
+{
+	if (mQueuedBytes >= receiveWindow || mDestination->state() != QAbstractSocket::ConnectedState) {
+		return;
+	}
+
+	const QByteArray data = mSource->read(receiveWindow - mQueuedBytes);
+	if (data.isEmpty()) {
+		return;
+	}
+
+	const qint64 now = timestamp();
+	mChunks.enqueue({data, releaseTime(now, data.size())});
+	mQueuedBytes += data.size();
+	mMaxQueuedBytes = std::max(mMaxQueuedBytes, mQueuedBytes);
+	emit received(data, now);
+	scheduleDelivery();
+}
+
+void ImpairedLink::deliver()
+{
+	const qint64 now = timestamp();
+	while (!mChunks.isEmpty() && mChunks.head().releaseTimeNs <= now) {
+		const Chunk chunk = mChunks.dequeue();
+		mQueuedBytes -= chunk.data.size();
+		mDestination->write(chunk.data);
+		emit delivered(chunk.data, now);
+	}
+
+	scheduleDelivery();
+	// window is opened again, the rest of data waits in socket buffer
+	if (mSource->bytesAvailable() > 0) {
+		readSource();
+	}
+}
+
+qint64 ImpairedLink::releaseTime(qint64 now, int size)
+{
+	qint64 sent = now;
+	if (mImpairment.bandwidthKbps > 0) {
+		// kilobits per second is the same as bits per millisecond
+		const qint64 transmissionNs = size * 8 * nsInMs / mImpairment.bandwidthKbps;
+		mLinkFreeTimeNs = std::max(mLinkFreeTimeNs, now) + transmissionNs;
+		sent = mLinkFreeTimeNs;
+	}
+
+	qint64 delayNs = mImpairment.latencyMs * nsInMs;
+	if (mImpairment.jitterMs > 0) {
+		std::uniform_int_distribution<qint64> jitter(-mImpairment.jitterMs * nsInMs, mImpairment.jitterMs * nsInMs);
+		delayNs = std::max<qint64>(0, delayNs + jitter(mRandom));
+	}
+
+	qint64 release = std::max(sent + delayNs, mLastReleaseTimeNs);
+	if (mImpairment.stallPeriodMs > 0 && mImpairment.stallDurationMs > 0) {
+		const qint64 periodNs = mImpairment.stallPeriodMs * nsInMs;
+		const qint64 phase = release % periodNs;
+		if (phase < mImpairment.stallDurationMs * nsInMs) {
+			release += mImpairment.stallDurationMs * nsInMs - phase;
+		}
+	}
+
+	mLastReleaseTimeNs = release;
+	return release;
+}
+
+void ImpairedLink::scheduleDelivery()
+{
+	if (mChunks.isEmpty()) {
+		mTimer.stop();
+		return;
+	}
+
+	const qint64 waitNs = mChunks.head().releaseTimeNs - timestamp();
+	// rounding up, so chunk is always due when timer fires
+	mTimer.start(static_cast<int>(std::max<qint64>(0, (waitNs + nsInMs - 1) / nsInMs)));
+}
@@ -0,0 +1,101 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+#include <QJsonObject>
+
+#include <random>
+
+class QTcpSocket;
+
+/// Parameters of bad network, all of them are 0 for a good one.
+struct Impairment
+{
+	int latencyMs = 0;
+
+	/// delay of every chunk is latency plus uniformly distributed [-jitter, jitter], order of data is kept
+	int jitterMs = 0;
+
+	/// kilobits per second in each direction, 0 means unlimited
+	int bandwidthKbps = 0;
+
+	/// every stallPeriodMs nothing is delivered for stallDurationMs
+	int stallPeriodMs = 0;
+	int stallDurationMs = 0;
+
+	/// fields that are absent in object are taken from defaults
+	static Impairment fromJson(const QJsonObject &object, const Impairment &defaults);
+	QJsonObject toJson() const;
+};
+
+/// One direction of proxied connection: data read from source is written to destination when network with given
+/// impairment would deliver it. Source is not read while too much data is in flight, so sender sees
+/// backpressure in the same way as on a slow link.
+class ImpairedLink : public QObject
+{
+	Q_OBJECT
+
+public:
+	ImpairedLink(QTcpSocket *source, QTcpSocket *destination, QObject *parent = nullptr);
+
+	void setImpairment(const Impairment &impairment);
+
+	/// maximal amount of data that was in flight since previous call
+	qint64 takeMaxQueuedBytes();
+
+	/// steady clock in nanoseconds, all links stall at the same time
+	static qint64 timestamp();
+
+signals:
+	void received(const QByteArray &data, qint64 timestampNs);
+	void delivered(const QByteArray &data, qint64 timestampNs);
+
+public slots:
+	void readSource();
+
+private slots:
+	void deliver();
+
+private:
+	struct Chunk
+	{
+		QByteArray data;
+		qint64 releaseTimeNs;
+	};
+
+	qint64 releaseTime(qint64 now, int size);
+	void scheduleDelivery();
+
+	QTcpSocket *mSource;
+	QTcpSocket *mDestination;
+	Impairment mImpairment;
+
+	QQueue<Chunk> mChunks;
+	qint64 mQueuedBytes;
+	qint64 mMaxQueuedBytes;
+
+	/// time when previous chunk is fully transmitted with limited bandwidth
+	qint64 mLinkFreeTimeNs;
+	qint64 mLastReleaseTimeNs;
+
+	QTimer mTimer;
+	std::mt19937 mRandom;
+};
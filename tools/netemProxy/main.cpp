@@ -0,0 +1,144 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+/* Proxy that makes network between gamepad and robot (or mock robot) bad in a reproducible way.
+ * Latency, jitter, bandwidth limit and periodic stalls are added to control connection and, if it is given,
+ * to camera connection. Staleness of pad values received by robot is measured for every phase of scenario
+ * and is printed as JSON at the end of scenario or on Ctrl+C.
+ *
+ * Usage: netemProxy --target host:port [--listen 4444] [--camera-target host:port] [--camera-listen 8080]
+ *         [--latency ms] [--jitter ms] [--bandwidth kbps] [--stall-period ms] [--stall-duration ms]
+ *         [--scenario file] [--report file]
+ * Example scenarios are in "scenarios" directory. */
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QFile>
+
+#include <cstdio>
+
+#include "proxyServer.h"
+#include "stalenessMeter.h"
+#include "scenarioRunner.h"
+#include "quitOnSignals.h"
+
+namespace {
+bool parseAddress(const QString &address, QString &host, quint16 &port)
+{
+	const int separator = address.lastIndexOf(':');
+	bool ok = false;
+	port = static_cast<quint16>(address.mid(separator + 1).toUInt(&ok));
+	host = address.left(separator);
+	return separator > 0 && ok;
+}
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication application(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	const QCommandLineOption targetOption("target", "Gamepad port of robot.", "host:port");
+	const QCommandLineOption listenOption("listen", "Port for gamepad to connect to, 4444 by default.", "port", "4444");
+	const QCommandLineOption cameraTargetOption("camera-target", "Camera of robot.", "host:port");
+	const QCommandLineOption cameraListenOption("camera-listen", "Port for video, 8080 by default.", "port", "8080");
+	const QCommandLineOption latencyOption("latency", "Delay of data in each direction.", "ms", "0");
+	const QCommandLineOption jitterOption("jitter", "Random change of delay.", "ms", "0");
+	const QCommandLineOption bandwidthOption("bandwidth", "Bandwidth in each direction, 0 is unlimited.", "kbps", "0");
+	const QCommandLineOption stallPeriodOption("stall-period", "Period of stalls.", "ms", "0");
+	const QCommandLineOption stallDurationOption("stall-duration", "Duration of stalls.", "ms", "0");
+	const QCommandLineOption scenarioOption("scenario", "JSON file with phases of impairment.", "file");
+	const QCommandLineOption reportOption("report", "File to write report to, stdout by default.", "file");
+	parser.addOptions({targetOption, listenOption, cameraTargetOption, cameraListenOption, latencyOption
+			, jitterOption, bandwidthOption, stallPeriodOption, stallDurationOption, scenarioOption, reportOption});
+	parser.process(application);
+
+	QString targetHost;
+	quint16 targetPort = 0;
+	if (!parseAddress(parser.value(targetOption), targetHost, targetPort)) {
+		fprintf(stderr, "Target should be given as host:port\n");
+		return 1;
+	}
+
+	ProxyServer control("control");
+	if (!control.listen(static_cast<quint16>(parser.value(listenOption).toUInt()), targetHost, targetPort)) {
+		fprintf(stderr, "Can not listen gamepad port: %s\n", qPrintable(control.errorString()));
+		return 1;
+	}
+
+	ProxyServer *camera = nullptr;
+	if (parser.isSet(cameraTargetOption)) {
+		QString cameraHost;
+		quint16 cameraPort = 0;
+		if (!parseAddress(parser.value(cameraTargetOption), cameraHost, cameraPort)) {
+			fprintf(stderr, "Camera target should be given as host:port\n");
+			return 1;
+		}
+
+		camera = new ProxyServer("camera", &application);
+		if (!camera->listen(static_cast<quint16>(parser.value(cameraListenOption).toUInt()), cameraHost, cameraPort)) {
+			fprintf(stderr, "Can not listen camera port: %s\n", qPrintable(camera->errorString()));
+			return 1;
+		}
+	}
+
+	StalenessMeter meter;
+	QObject::connect(&control, &ProxyServer::connectionOpened, [&meter](ImpairedLink *uplink, ImpairedLink *) {
+		QObject::connect(uplink, &ImpairedLink::received, &meter, &StalenessMeter::handleSent);
+		QObject::connect(uplink, &ImpairedLink::delivered, &meter, &StalenessMeter::handleDelivered);
+	});
+
+	Impairment impairment;
+	impairment.latencyMs = parser.value(latencyOption).toInt();
+	impairment.jitterMs = parser.value(jitterOption).toInt();
+	impairment.bandwidthKbps = parser.value(bandwidthOption).toInt();
+	impairment.stallPeriodMs = parser.value(stallPeriodOption).toInt();
+	impairment.stallDurationMs = parser.value(stallDurationOption).toInt();
+
+	ScenarioRunner runner(&control, camera, &meter);
+	if (!parser.isSet(scenarioOption)) {
+		runner.setSinglePhase(impairment);
+	} else if (!runner.loadScenario(parser.value(scenarioOption), impairment)) {
+		fprintf(stderr, "%s\n", qPrintable(runner.errorString()));
+		return 1;
+	}
+
+	if (!quitOnSignals(application)) {
+		fprintf(stderr, "Can not set up signal handling\n");
+		return 1;
+	}
+
+	QObject::connect(&runner, &ScenarioRunner::finished, &application, &QCoreApplication::quit);
+	runner.start();
+	application.exec();
+	runner.stop();
+
+	const QByteArray json = QJsonDocument(runner.report()).toJson();
+	if (parser.isSet(reportOption)) {
+		QFile file(parser.value(reportOption));
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+			fprintf(stderr, "Can not write report to %s\n", qPrintable(parser.value(reportOption)));
+			return 1;
+		}
+	} else {
+		fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+	}
+
+	return 0;
+}
@@ -0,0 +1,35 @@
+# Copyright 2017 Konstantin Batoev.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+include(../tools.pri)
+
+QT += core network
+
+TARGET = netemProxy
+
+SOURCES += main.cpp \
+        impairedLink.cpp \
+        proxyServer.cpp \
+        stalenessMeter.cpp \
+        scenarioRunner.cpp \
+        $$GAMEPAD_DIR/commandProtocol.cpp \
+        $$COMMON_DIR/quitOnSignals.cpp
+
+HEADERS += \
+        impairedLink.h \
+        proxyServer.h \
+        stalenessMeter.h \
+        scenarioRunner.h \
+        $$GAMEPAD_DIR/commandProtocol.h \
+        $$COMMON_DIR/quitOnSignals.h
@@ -0,0 +1,111 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "proxyServer.h"
+
+#include <QTcpSocket>
+
+#include <algorithm>
+#include <cstdio>
+
+ProxyServer::ProxyServer(const QString &name, QObject *parent)
+	: QObject(parent)
+	, mName(name)
+	, mTargetPort(0)
+{
+	connect(&mServer, SIGNAL(newConnection()), this, SLOT(acceptConnections()));
+}
+
+bool ProxyServer::listen(quint16 port, const QString &targetHost, quint16 targetPort)
+{
+	mTargetHost = targetHost;
+	mTargetPort = targetPort;
+	return mServer.listen(QHostAddress::Any, port);
+}
+
+QString ProxyServer::errorString() const
+{
+	return mServer.errorString();
+}
+
+void ProxyServer::setImpairment(const Impairment &impairment)
+{
+	mImpairment = impairment;
+	for (const Connection &connection : mConnections) {
+		connection.uplink->setImpairment(impairment);
+		connection.downlink->setImpairment(impairment);
+	}
+}
+
+void ProxyServer::takeMaxQueuedBytes(qint64 &uplink, qint64 &downlink)
+{
+	uplink = 0;
+	downlink = 0;
+	for (const Connection &connection : mConnections) {
+		uplink = std::max(uplink, connection.uplink->takeMaxQueuedBytes());
+		downlink = std::max(downlink, connection.downlink->takeMaxQueuedBytes());
+	}
+}
+
+void ProxyServer::acceptConnections()
+{
+	while (mServer.hasPendingConnections()) {
+		Connection connection;
+		connection.client = mServer.nextPendingConnection();
+		connection.target = new QTcpSocket(this);
+		connection.client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		connection.target->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		connection.uplink = new ImpairedLink(connection.client, connection.target, connection.client);
+		connection.downlink = new ImpairedLink(connection.target, connection.client, connection.client);
+		connection.uplink->setImpairment(mImpairment);
+		connection.downlink->setImpairment(mImpairment);
+
+		// data that came before target is connected waits in client socket
+		connect(connection.target, SIGNAL(connected()), connection.uplink, SLOT(readSource()));
+		connect(connection.client, SIGNAL(disconnected()), this, SLOT(closeConnection()));
+		connect(connection.target, SIGNAL(disconnected()), this, SLOT(closeConnection()));
+		connect(connection.target, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(closeConnection()));
+		mConnections.append(connection);
+
+		connection.target->connectToHost(mTargetHost, mTargetPort);
+		fprintf(stderr, "%s: connection from %s\n", qPrintable(mName)
+				, qPrintable(connection.client->peerAddress().toString()));
+		emit connectionOpened(connection.uplink, connection.downlink);
+	}
+}
+
+void ProxyServer::closeConnection()
+{
+	QObject *socket = sender();
+	for (int i = 0; i < mConnections.size(); ++i) {
+		const Connection connection = mConnections.at(i);
+		if (connection.client != socket && connection.target != socket) {
+			continue;
+		}
+
+		mConnections.removeAt(i);
+		disconnect(connection.client, nullptr, this, nullptr);
+		disconnect(connection.target, nullptr, this, nullptr);
+		connection.client->abort();
+		connection.target->abort();
+		// links are children of client socket
+		connection.client->deleteLater();
+		connection.target->deleteLater();
+		fprintf(stderr, "%s: connection closed\n", qPrintable(mName));
+		return;
+	}
+}
@@ -0,0 +1,66 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QTcpServer>
+#include <QList>
+
+#include "impairedLink.h"
+
+/// Accepts connections on local port and connects each of them to target, data goes both ways through impaired links.
+class ProxyServer : public QObject
+{
+	Q_OBJECT
+
+public:
+	ProxyServer(const QString &name, QObject *parent = nullptr);
+
+	bool listen(quint16 port, const QString &targetHost, quint16 targetPort);
+	QString errorString() const;
+
+	/// impairment of both directions of all current and future connections
+	void setImpairment(const Impairment &impairment);
+
+	/// maximal amount of data in flight to target and back since previous call
+	void takeMaxQueuedBytes(qint64 &uplink, qint64 &downlink);
+
+signals:
+	/// uplink goes from client to target
+	void connectionOpened(ImpairedLink *uplink, ImpairedLink *downlink);
+
+private slots:
+	void acceptConnections();
+	void closeConnection();
+
+private:
+	struct Connection
+	{
+		QTcpSocket *client;
+		QTcpSocket *target;
+		ImpairedLink *uplink;
+		ImpairedLink *downlink;
+	};
+
+	QString mName;
+	QTcpServer mServer;
+	QString mTargetHost;
+	quint16 mTargetPort;
+	Impairment mImpairment;
+	QList<Connection> mConnections;
+};
@@ -0,0 +1,153 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "scenarioRunner.h"
+
+#include <QFile>
+#include <QJsonDocument>
+
+#include <cstdio>
+
+#include "proxyServer.h"
+#include "stalenessMeter.h"
+
+ScenarioRunner::ScenarioRunner(ProxyServer *control, ProxyServer *camera, StalenessMeter *meter, QObject *parent)
+	: QObject(parent)
+	, mControl(control)
+	, mCamera(camera)
+	, mMeter(meter)
+	, mCurrentPhase(-1)
+{
+	mPhaseTimer.setSingleShot(true);
+	connect(&mPhaseTimer, SIGNAL(timeout()), this, SLOT(nextPhase()));
+}
+
+void ScenarioRunner::setSinglePhase(const Impairment &impairment)
+{
+	QJsonObject phase = impairment.toJson();
+	phase.insert("name", "command line");
+	mPhases = QJsonArray({phase});
+}
+
+bool ScenarioRunner::loadScenario(const QString &fileName, const Impairment &defaults)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) {
+		mErrorString = QString("Can not open scenario %1: %2").arg(fileName, file.errorString());
+		return false;
+	}
+
+	QJsonParseError error;
+	const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+	mPhases = document.object().value("phases").toArray();
+	if (error.error != QJsonParseError::NoError || mPhases.isEmpty()) {
+		mErrorString = QString("Scenario %1 has no phases: %2").arg(fileName, error.errorString());
+		return false;
+	}
+
+	mDefaults = defaults;
+	return true;
+}
+
+QString ScenarioRunner::errorString() const
+{
+	return mErrorString;
+}
+
+void ScenarioRunner::start()
+{
+	mResults = QJsonArray();
+	mCurrentPhase = -1;
+	nextPhase();
+}
+
+QJsonObject ScenarioRunner::report() const
+{
+	QJsonObject result;
+	result.insert("phases", mResults);
+	return result;
+}
+
+void ScenarioRunner::stop()
+{
+	if (mCurrentPhase < 0 || mCurrentPhase >= mPhases.size()) {
+		return;
+	}
+
+	mPhaseTimer.stop();
+	finishPhase();
+	mCurrentPhase = mPhases.size();
+	emit finished();
+}
+
+void ScenarioRunner::nextPhase()
+{
+	if (mCurrentPhase >= 0) {
+		finishPhase();
+	}
+
+	++mCurrentPhase;
+	if (mCurrentPhase >= mPhases.size()) {
+		emit finished();
+		return;
+	}
+
+	const QJsonObject phase = mPhases.at(mCurrentPhase).toObject();
+	const Impairment control = Impairment::fromJson(phase, mDefaults);
+	const Impairment camera = Impairment::fromJson(phase.value("camera").toObject(), control);
+	mControl->setImpairment(control);
+	if (mCamera) {
+		mCamera->setImpairment(camera);
+	}
+
+	qint64 uplink = 0;
+	qint64 downlink = 0;
+	mControl->takeMaxQueuedBytes(uplink, downlink);
+	if (mCamera) {
+		mCamera->takeMaxQueuedBytes(uplink, downlink);
+	}
+
+	mMeter->start();
+	const int seconds = phase.value("seconds").toInt();
+	if (seconds > 0) {
+		mPhaseTimer.start(seconds * 1000);
+	}
+
+	fprintf(stderr, "Phase \"%s\"\n", qPrintable(phase.value("name").toString()));
+}
+
+void ScenarioRunner::finishPhase()
+{
+	const QJsonObject phase = mPhases.at(mCurrentPhase).toObject();
+	const Impairment control = Impairment::fromJson(phase, mDefaults);
+
+	QJsonObject result = mMeter->takeStatistics();
+	result.insert("name", phase.value("name").toString());
+	result.insert("control", control.toJson());
+
+	qint64 uplink = 0;
+	qint64 downlink = 0;
+	mControl->takeMaxQueuedBytes(uplink, downlink);
+	result.insert("maxControlBytesInFlight", static_cast<double>(uplink));
+	if (mCamera) {
+		result.insert("camera", Impairment::fromJson(phase.value("camera").toObject(), control).toJson());
+		mCamera->takeMaxQueuedBytes(uplink, downlink);
+		result.insert("maxCameraBytesInFlight", static_cast<double>(downlink));
+	}
+
+	mResults.append(result);
+}
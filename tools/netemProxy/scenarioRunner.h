@@ -0,0 +1,74 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "impairedLink.h"
+
+class ProxyServer;
+class StalenessMeter;
+
+/// Runs phases of a scenario one after another, each phase sets impairments of proxies for its duration,
+/// then its statistics are added to report.
+/// Scenario is JSON like {"phases": [{"name": "bad wifi", "seconds": 20, "latency": 80, "jitter": 40,
+/// "camera": {"bandwidth": 2000}}]}, impairment fields are described by Impairment::fromJson(),
+/// camera link has the same impairment as control one unless "camera" object changes it.
+class ScenarioRunner : public QObject
+{
+	Q_OBJECT
+
+public:
+	ScenarioRunner(ProxyServer *control, ProxyServer *camera, StalenessMeter *meter, QObject *parent = nullptr);
+
+	/// scenario of one endless phase, it is ended by stop()
+	void setSinglePhase(const Impairment &impairment);
+	bool loadScenario(const QString &fileName, const Impairment &defaults);
+	QString errorString() const;
+
+	void start();
+	QJsonObject report() const;
+
+public slots:
+	/// ends current phase, so its statistics are in report
+	void stop();
+
+signals:
+	void finished();
+
+private slots:
+	void nextPhase();
+
+private:
+	void finishPhase();
+
+	ProxyServer *mControl;
+	ProxyServer *mCamera;
+	StalenessMeter *mMeter;
+
+	QJsonArray mPhases;
+	Impairment mDefaults;
+	int mCurrentPhase;
+	QTimer mPhaseTimer;
+
+	QJsonArray mResults;
+	QString mErrorString;
+};
@@ -0,0 +1,188 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "stalenessMeter.h"
+
+#include <QJsonArray>
+
+#include <algorithm>
+
+#include "impairedLink.h"
+
+namespace {
+const int sampleIntervalMs = 5;
+
+double percentileMs(QVector<qint64> values, double fraction)
+{
+	if (values.isEmpty()) {
+		return 0;
+	}
+
+	const int index = std::min(values.size() - 1, static_cast<int>(values.size() * fraction));
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values.at(index) / 1e6;
+}
+
+double averageMs(const QVector<qint64> &values)
+{
+	if (values.isEmpty()) {
+		return 0;
+	}
+
+	double sum = 0;
+	for (const qint64 value : values) {
+		sum += value;
+	}
+
+	return sum / values.size() / 1e6;
+}
+}
+
+bool StalenessMeter::PadState::operator==(const PadState &other) const
+{
+	return isPressed == other.isPressed && (!isPressed || (x == other.x && y == other.y));
+}
+
+bool StalenessMeter::PadState::operator!=(const PadState &other) const
+{
+	return !(*this == other);
+}
+
+StalenessMeter::StalenessMeter(QObject *parent)
+	: QObject(parent)
+	, mSentCommands(0)
+{
+	mStaleSinceNs[0] = -1;
+	mStaleSinceNs[1] = -1;
+	mSampleTimer.setTimerType(Qt::PreciseTimer);
+	mSampleTimer.setInterval(sampleIntervalMs);
+	connect(&mSampleTimer, SIGNAL(timeout()), this, SLOT(sample()));
+}
+
+void StalenessMeter::start()
+{
+	mDeliveryDelaysNs.clear();
+	mStalenessSamplesNs.clear();
+	mSentCommands = 0;
+	mSampleTimer.start();
+}
+
+QJsonObject StalenessMeter::takeStatistics()
+{
+	int staleSamples = 0;
+	for (const qint64 staleness : mStalenessSamplesNs) {
+		if (staleness > 0) {
+			++staleSamples;
+		}
+	}
+
+	QJsonObject staleness;
+	staleness.insert("averageMs", averageMs(mStalenessSamplesNs));
+	staleness.insert("medianMs", percentileMs(mStalenessSamplesNs, 0.5));
+	staleness.insert("p95Ms", percentileMs(mStalenessSamplesNs, 0.95));
+	staleness.insert("p99Ms", percentileMs(mStalenessSamplesNs, 0.99));
+	staleness.insert("maxMs", percentileMs(mStalenessSamplesNs, 1));
+	staleness.insert("staleFraction", mStalenessSamplesNs.isEmpty()
+			? 0.0 : static_cast<double>(staleSamples) / mStalenessSamplesNs.size());
+
+	QJsonObject delay;
+	delay.insert("averageMs", averageMs(mDeliveryDelaysNs));
+	delay.insert("p95Ms", percentileMs(mDeliveryDelaysNs, 0.95));
+	delay.insert("maxMs", percentileMs(mDeliveryDelaysNs, 1));
+
+	QJsonObject result;
+	result.insert("sentCommands", mSentCommands);
+	result.insert("deliveredCommands", mDeliveryDelaysNs.size());
+	result.insert("padStaleness", staleness);
+	result.insert("commandDelay", delay);
+
+	start();
+	return result;
+}
+
+void StalenessMeter::handleSent(const QByteArray &data, qint64 timestampNs)
+{
+	const QVector<int> pads = apply(mGamepad, data);
+	for (const int pad : pads) {
+		mSentTimes.enqueue(timestampNs);
+		if (pad != -1) {
+			mPendingPadTimes[pad].enqueue(timestampNs);
+		}
+	}
+
+	mSentCommands += pads.size();
+	updateStaleness();
+}
+
+void StalenessMeter::handleDelivered(const QByteArray &data, qint64 timestampNs)
+{
+	const QVector<int> pads = apply(mRobot, data);
+	for (const int pad : pads) {
+		if (!mSentTimes.isEmpty()) {
+			mDeliveryDelaysNs.append(timestampNs - mSentTimes.dequeue());
+		}
+
+		if (pad != -1 && !mPendingPadTimes[pad].isEmpty()) {
+			mPendingPadTimes[pad].dequeue();
+		}
+	}
+
+	updateStaleness();
+}
+
+void StalenessMeter::sample()
+{
+	const qint64 now = ImpairedLink::timestamp();
+	for (const qint64 staleSince : mStaleSinceNs) {
+		mStalenessSamplesNs.append(staleSince == -1 ? 0 : now - staleSince);
+	}
+}
+
+QVector<int> StalenessMeter::apply(Side &side, const QByteArray &data)
+{
+	side.buffer += data;
+	QVector<int> pads;
+	int lineEnd = side.buffer.indexOf('\n');
+	while (lineEnd != -1) {
+		const GamepadCommand command = GamepadCommand::parse(side.buffer.left(lineEnd));
+		side.buffer.remove(0, lineEnd + 1);
+		if (command.type == GamepadCommand::Type::pad) {
+			PadState &pad = side.pads[command.id - 1];
+			pad.isPressed = true;
+			pad.x = command.x;
+			pad.y = command.y;
+			pads.append(command.id - 1);
+		} else if (command.type == GamepadCommand::Type::padUp) {
+			side.pads[command.id - 1].isPressed = false;
+			pads.append(command.id - 1);
+		} else {
+			pads.append(-1);
+		}
+
+		lineEnd = side.buffer.indexOf('\n');
+	}
+
+	return pads;
+}
+
+void StalenessMeter::updateStaleness()
+{
+	for (int i = 0; i < 2; ++i) {
+		const bool isStale = mGamepad.pads[i] != mRobot.pads[i] && !mPendingPadTimes[i].isEmpty();
+		mStaleSinceNs[i] = isStale ? mPendingPadTimes[i].head() : -1;
+	}
+}
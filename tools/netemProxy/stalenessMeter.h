@@ -0,0 +1,86 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <QQueue>
+#include <QJsonObject>
+
+#include "commandProtocol.h"
+
+/// Watches commands that go through control link and measures how stale pad values known to robot are:
+/// robot's value of a pad is stale since the moment gamepad sent the oldest value that robot has not received yet,
+/// until robot's value is the same as gamepad's one. Staleness of both pads is sampled every few milliseconds.
+class StalenessMeter : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit StalenessMeter(QObject *parent = nullptr);
+
+	/// starts new measurement, statistics of the previous one are returned by takeStatistics()
+	void start();
+	QJsonObject takeStatistics();
+
+public slots:
+	void handleSent(const QByteArray &data, qint64 timestampNs);
+	void handleDelivered(const QByteArray &data, qint64 timestampNs);
+
+private slots:
+	void sample();
+
+private:
+	struct PadState
+	{
+		bool isPressed = false;
+		int x = 0;
+		int y = 0;
+
+		bool operator==(const PadState &other) const;
+		bool operator!=(const PadState &other) const;
+	};
+
+	struct Side
+	{
+		QByteArray buffer;
+		PadState pads[2];
+	};
+
+	/// applies complete lines of data to pads of one side, returns pad index of every command, -1 for non-pad ones
+	QVector<int> apply(Side &side, const QByteArray &data);
+	void updateStaleness();
+
+	Side mGamepad;
+	Side mRobot;
+
+	/// when robot's value of a pad became stale, -1 if it is the same as gamepad's one
+	qint64 mStaleSinceNs[2];
+
+	/// times when pad values that are not delivered yet were sent by gamepad
+	QQueue<qint64> mPendingPadTimes[2];
+
+	/// times when commands that are not delivered yet were sent by gamepad
+	QQueue<qint64> mSentTimes;
+	QVector<qint64> mDeliveryDelaysNs;
+	QVector<qint64> mStalenessSamplesNs;
+	int mSentCommands;
+
+	QTimer mSampleTimer;
+};
@@ -0,0 +1,359 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+/* Checks of gamepad behaviour that need a real event loop, sockets and windows: release of held pads when
+ * gamepad window stops getting input but not while automation client drives, and search of robots in a subnet.
+ * Windows are created on offscreen platform unless QT_QPA_PLATFORM says otherwise. Results are printed as JSON,
+ * exit code is 3 if some check fails.
+ *
+ * Usage: selfChecks [--filter group] */
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
+#include <QtGui/QKeyEvent>
+#include <QtNetwork/QLocalSocket>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtWidgets/QApplication>
+#include <QtWidgets/QDialog>
+#include <QtWidgets/QWidget>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+#include "strategy.h"
+#include "automationServer.h"
+#include "connectionManager.h"
+#include "inputDispatcher.h"
+#include "robotScanner.h"
+
+namespace {
+
+struct Result
+{
+	QString name;
+	bool isPassed;
+	QString details;
+};
+
+/// runs event loop until condition is true or time is out, returns the condition
+bool waitFor(const std::function<bool()> &condition, int timeoutMs)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (!condition() && timer.elapsed() < timeoutMs) {
+		QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+	}
+
+	return condition();
+}
+
+/// robot on loopback connection that keeps everything gamepad sends to it
+class LoopbackRobot
+{
+public:
+	explicit LoopbackRobot(int deadManTimeoutMs)
+		: mRobot(nullptr)
+	{
+		mServer.listen(QHostAddress::LocalHost, 0);
+		mManager.setGamepadIp("127.0.0.1");
+		mManager.setGamepadPort(mServer.serverPort());
+		mManager.setDeadManTimeout(deadManTimeoutMs);
+		mManager.connectToHost();
+		if (waitFor([this]() { return mServer.hasPendingConnections() && mManager.isConnected(); }, 3000)) {
+			mRobot = mServer.nextPendingConnection();
+			QObject::connect(mRobot, &QTcpSocket::readyRead, [this]() {
+				mReceived += mRobot->readAll();
+			});
+		}
+	}
+
+	~LoopbackRobot()
+	{
+		mManager.disconnectFromHost();
+	}
+
+	bool isConnected() const
+	{
+		return mRobot != nullptr;
+	}
+
+	ConnectionManager &manager()
+	{
+		return mManager;
+	}
+
+	const QByteArray &received() const
+	{
+		return mReceived;
+	}
+
+private:
+	QTcpServer mServer;
+	QTcpSocket *mRobot;
+	ConnectionManager mManager;
+	QByteArray mReceived;
+};
+
+/// the same heartbeats as GamepadForm sends
+void startHeartbeats(QTimer &timer, const QWidget &window, const AutomationServer &automation
+		, ConnectionManager &manager)
+{
+	QObject::connect(&timer, &QTimer::timeout, [&window, &automation, &manager]() {
+		if (InputDispatcher::isReceivingInput(&window) || automation.hasClients()) {
+			manager.heartbeat();
+		}
+	});
+	timer.start(manager.heartbeatInterval());
+}
+
+/// a key is held in gamepad window when a modal dialog opens over it, robot must get release of the pad
+/// after dead-man timeout, and must not get it while the window has input
+void checkDialog(QVector<Result> &results)
+{
+	const int timeoutMs = 200;
+
+	QWidget window;
+	window.show();
+	window.activateWindow();
+	if (!waitFor([&window]() { return InputDispatcher::isReceivingInput(&window); }, 3000)) {
+		results.append({"deadMan.dialog", false, "window did not become active"});
+		return;
+	}
+
+	LoopbackRobot robot(timeoutMs);
+	if (!robot.isConnected()) {
+		results.append({"deadMan.dialog", false, "loopback connection is not established"});
+		return;
+	}
+
+	AutomationServer automation;
+	QTimer heartbeatTimer;
+	startHeartbeats(heartbeatTimer, window, automation, robot.manager());
+
+	Strategy *strategy = Strategy::getStrategy(standartStrategy);
+	strategy->reset();
+	const QMetaObject::Connection commands = QObject::connect(strategy, &Strategy::commandPrepared
+			, &robot.manager(), &ConnectionManager::send);
+	QKeyEvent press(QEvent::KeyPress, Qt::Key_W, Qt::NoModifier);
+	strategy->processEvent(&press);
+	const bool isHoldSent = waitFor([&robot]() { return robot.received().contains("pad 1 "); }, 1000);
+	waitFor([]() { return false; }, 3 * timeoutMs);
+	const bool isReleasedEarly = robot.received().contains("pad 1 up");
+
+	QDialog dialog(&window);
+	dialog.open();
+	QElapsedTimer sinceDialog;
+	sinceDialog.start();
+	// watchdog checks silence a few times per timeout, so release comes a bit later than timeout
+	const int allowedMs = timeoutMs + 2 * robot.manager().heartbeatInterval() + 300;
+	const bool isReleased = waitFor([&robot]() { return robot.received().contains("pad 1 up"); }, allowedMs);
+	const qint64 releaseMs = sinceDialog.elapsed();
+	dialog.close();
+
+	QObject::disconnect(commands);
+	strategy->reset();
+
+	QString details;
+	if (!isHoldSent) {
+		details = "pad command was not sent";
+	} else if (isReleasedEarly) {
+		details = "pad was released while window had input";
+	} else if (!isReleased) {
+		details = QString("pad was not released in %1 ms after dialog was opened").arg(allowedMs);
+	} else {
+		details = QString("pad was released in %1 ms after dialog was opened").arg(releaseMs);
+	}
+
+	results.append({"deadMan.dialog", isHoldSent && !isReleasedEarly && isReleased, details});
+}
+
+/// automation client holds a pad while gamepad window is not active, robot must not get its release
+/// until the client disconnects
+void checkAutomation(QVector<Result> &results)
+{
+	const int timeoutMs = 200;
+
+	// window that is not shown is not active
+	QWidget window;
+	LoopbackRobot robot(timeoutMs);
+	if (!robot.isConnected()) {
+		results.append({"deadMan.automation", false, "loopback connection is not established"});
+		return;
+	}
+
+	AutomationServer automation;
+	const QString path = QDir::temp().filePath(QString("trik-gamepad-selfChecks-%1")
+			.arg(QCoreApplication::applicationPid()));
+	if (!automation.listen(path)) {
+		results.append({"deadMan.automation", false, "can not listen on " + path + ": " + automation.errorString()});
+		return;
+	}
+
+	QObject::connect(&automation, &AutomationServer::commandPrepared, &robot.manager(), &ConnectionManager::send);
+	QTimer heartbeatTimer;
+	startHeartbeats(heartbeatTimer, window, automation, robot.manager());
+
+	QLocalSocket client;
+	client.connectToServer(path);
+	client.write("pad 1 50 50\n");
+	const bool isHoldSent = waitFor([&robot]() { return robot.received().contains("pad 1 "); }, 1000);
+	waitFor([]() { return false; }, 3 * timeoutMs);
+	const bool isReleasedEarly = robot.received().contains("pad 1 up");
+
+	client.disconnectFromServer();
+	const bool isReleased = waitFor([&robot]() { return robot.received().contains("pad 1 up"); }, 1000);
+	automation.close();
+
+	QString details;
+	if (InputDispatcher::isReceivingInput(&window)) {
+		details = "window that is not shown is considered active";
+	} else if (!isHoldSent) {
+		details = "pad command of automation client was not sent";
+	} else if (isReleasedEarly) {
+		details = "pad of automation client was released while the client was connected";
+	} else if (!isReleased) {
+		details = "pad of automation client was not released after it disconnected";
+	} else {
+		details = "pad was held while the client was connected";
+	}
+
+	results.append({"deadMan.automation", !InputDispatcher::isReceivingInput(&window) && isHoldSent
+			&& !isReleasedEarly && isReleased, details});
+}
+
+void checkDeadMan(QVector<Result> &results)
+{
+	checkDialog(results);
+	checkAutomation(results);
+}
+
+/// scans 127.0.0.0/24 with robots listening on some of its addresses, every open port must be found exactly once
+bool scan(quint16 gamepadPort, quint16 cameraPort, const QSet<QString> &expected, QString &details)
+{
+	RobotScanner scanner;
+	QStringList found;
+	bool isFinished = false;
+	QObject::connect(&scanner, &RobotScanner::portFound, [&found](const QHostAddress &address, quint16 port) {
+		found.append(QString("%1:%2").arg(address.toString()).arg(port));
+	});
+	QObject::connect(&scanner, &RobotScanner::finished, [&isFinished]() {
+		isFinished = true;
+	});
+
+	if (!scanner.start({"127.0.0.0/24"}, gamepadPort, cameraPort)
+			|| !waitFor([&isFinished]() { return isFinished; }, 10000)) {
+		details = "scan did not finish";
+		return false;
+	}
+
+	std::sort(found.begin(), found.end());
+	details = "found " + found.join(", ");
+	QSet<QString> foundSet;
+	for (const QString &port : found) {
+		foundSet.insert(port);
+	}
+
+	return foundSet == expected && found.size() == expected.size();
+}
+
+void checkScan(QVector<Result> &results)
+{
+	QTcpServer gamepad2;
+	QTcpServer gamepad5;
+	QTcpServer camera5;
+	if (!gamepad2.listen(QHostAddress("127.0.0.2"), 0)
+			|| !gamepad5.listen(QHostAddress("127.0.0.5"), gamepad2.serverPort())
+			|| !camera5.listen(QHostAddress("127.0.0.5"), 0)) {
+		results.append({"scan.ports", false, "can not listen on 127.0.0.2 and 127.0.0.5"});
+		return;
+	}
+
+	const QString gamepadPort = QString::number(gamepad2.serverPort());
+	const QString cameraPort = QString::number(camera5.serverPort());
+	QString details;
+	bool isPassed = scan(gamepad2.serverPort(), camera5.serverPort()
+			, {"127.0.0.2:" + gamepadPort, "127.0.0.5:" + gamepadPort, "127.0.0.5:" + cameraPort}, details);
+	results.append({"scan.ports", isPassed, details});
+
+	// camera on the same port as gamepad
+	isPassed = scan(gamepad2.serverPort(), gamepad2.serverPort()
+			, {"127.0.0.2:" + gamepadPort, "127.0.0.5:" + gamepadPort}, details);
+	results.append({"scan.sharedPort", isPassed, details});
+}
+
+QJsonObject toJson(const QVector<Result> &results)
+{
+	QJsonObject json;
+	for (const Result &result : results) {
+		QJsonObject item;
+		item["passed"] = result.isPassed;
+		item["details"] = result.details;
+		json[result.name] = item;
+	}
+
+	return json;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+
+	QApplication application(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	const QCommandLineOption filterOption("filter", "Run only given group: deadMan or scan.", "group");
+	parser.addOption(filterOption);
+	parser.process(application);
+
+	const QList<QPair<QString, void (*)(QVector<Result> &)>> groups = {
+		{"deadMan", checkDeadMan}
+		, {"scan", checkScan}
+	};
+
+	QVector<Result> results;
+	for (const auto &group : groups) {
+		if (!parser.isSet(filterOption) || parser.value(filterOption) == group.first) {
+			fprintf(stderr, "Running %s checks\n", qPrintable(group.first));
+			group.second(results);
+		}
+	}
+
+	const QByteArray json = QJsonDocument(toJson(results)).toJson();
+	fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+
+	int failed = 0;
+	for (const Result &result : results) {
+		if (!result.isPassed) {
+			fprintf(stderr, "%s failed: %s\n", qPrintable(result.name), qPrintable(result.details));
+			++failed;
+		}
+	}
+
+	return failed > 0 ? 3 : 0;
+}
@@ -0,0 +1,279 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+/* Throughput benchmark of shared memory export of video frames.
+ * Publishes synthetic frames as fast as possible (or with given rate) and reads them in another thread the same way
+ * an external process does: through the socket, eventfd and sequence locks described in sharedFrameFormat.h.
+ *
+ * Usage: sharedFrameBenchmark [width height seconds fps]
+ * fps = 0 means "as fast as possible". */
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sharedFramePublisher.h"
+
+using namespace sharedFrames;
+
+namespace {
+
+const char shmName[] = "/trik-gamepad-frames-benchmark";
+
+struct ReaderResult
+{
+	bool isConnected = false;
+	quint64 frames = 0;
+	quint64 missedFrames = 0;
+	quint64 tornFrames = 0;
+	quint64 bytes = 0;
+	double totalLatencyNs = 0;
+	quint64 maxLatencyNs = 0;
+};
+
+quint64 monotonicNs()
+{
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return static_cast<quint64>(time.tv_sec) * 1000000000ULL + static_cast<quint64>(time.tv_nsec);
+}
+
+/// connects to publisher socket and receives name of shared memory and eventfd
+bool connectToPublisher(int &socketFd, int &eventFd, std::string &name)
+{
+	socketFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	const std::string path(shmName + 1);
+	memcpy(address.sun_path + 1, path.data(), path.size());
+	const socklen_t length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + path.size());
+	if (socketFd == -1) {
+		return false;
+	}
+
+	if (connect(socketFd, reinterpret_cast<sockaddr *>(&address), length) == -1) {
+		close(socketFd);
+		socketFd = -1;
+		return false;
+	}
+
+	char data[256];
+	iovec vector;
+	vector.iov_base = data;
+	vector.iov_len = sizeof(data);
+	char control[CMSG_SPACE(sizeof(int))];
+	msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &vector;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	const ssize_t received = recvmsg(socketFd, &message, 0);
+	cmsghdr *controlMessage = CMSG_FIRSTHDR(&message);
+	if (received <= 0 || !controlMessage || controlMessage->cmsg_type != SCM_RIGHTS) {
+		close(socketFd);
+		socketFd = -1;
+		return false;
+	}
+
+	memcpy(&eventFd, CMSG_DATA(controlMessage), sizeof(int));
+	name.assign(data, static_cast<size_t>(received));
+	// socket is kept open while reader works, publisher drops reader when it is closed
+	return true;
+}
+
+void readFrames(const std::atomic<bool> &isRunning, ReaderResult &result)
+{
+	int socketFd = -1;
+	int eventFd = -1;
+	std::string name;
+	for (int attempt = 0; attempt < 100 && !connectToPublisher(socketFd, eventFd, name); ++attempt) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	if (eventFd == -1) {
+		return;
+	}
+
+	const int shmFd = shm_open(name.c_str(), O_RDONLY, 0);
+	SharedFrameRingHeader header;
+	const bool isHeaderRead = shmFd != -1
+			&& read(shmFd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header));
+	const size_t size = isHeaderRead ? static_cast<size_t>(ringSize(header.slotSize, header.slotCount)) : 0;
+	void *mapped = isHeaderRead ? mmap(nullptr, size, PROT_READ, MAP_SHARED, shmFd, 0) : MAP_FAILED;
+	if (mapped == MAP_FAILED) {
+		if (shmFd != -1) {
+			close(shmFd);
+		}
+
+		close(eventFd);
+		close(socketFd);
+		return;
+	}
+
+	result.isConnected = true;
+	const uchar *memory = static_cast<const uchar *>(mapped);
+	const SharedFrameRingHeader *ring = reinterpret_cast<const SharedFrameRingHeader *>(memory);
+	std::vector<uchar> frame(header.slotSize);
+	quint64 expectedSequence = __atomic_load_n(&ring->nextSequence, __ATOMIC_ACQUIRE);
+
+	pollfd descriptor = {eventFd, POLLIN, 0};
+	while (isRunning) {
+		if (poll(&descriptor, 1, 100) <= 0) {
+			continue;
+		}
+
+		uint64_t counter = 0;
+		if (read(eventFd, &counter, sizeof(counter)) != static_cast<ssize_t>(sizeof(counter))) {
+			continue;
+		}
+
+		// taking only the latest frame, like real-time consumer does
+		const quint64 next = __atomic_load_n(&ring->nextSequence, __ATOMIC_ACQUIRE);
+		if (next == 0) {
+			continue;
+		}
+
+		const quint64 sequence = next - 1;
+		const uchar *slotMemory = memory + slotOffset(ring->slotSize, static_cast<uint32_t>(sequence % ring->slotCount));
+		const SharedFrameSlotHeader *slot = reinterpret_cast<const SharedFrameSlotHeader *>(slotMemory);
+
+		const quint64 lock = __atomic_load_n(&slot->lock, __ATOMIC_ACQUIRE);
+		const quint32 frameSize = slot->size;
+		const quint64 timestamp = slot->timestampNs;
+		if (lock % 2 == 0 && frameSize <= header.slotSize) {
+			memcpy(frame.data(), slotMemory + sizeof(SharedFrameSlotHeader), frameSize);
+		}
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (lock % 2 != 0 || __atomic_load_n(&slot->lock, __ATOMIC_RELAXED) != lock || slot->sequence != sequence) {
+			++result.tornFrames;
+			continue;
+		}
+
+		const quint64 latency = monotonicNs() - timestamp;
+		++result.frames;
+		result.bytes += frameSize;
+		result.totalLatencyNs += static_cast<double>(latency);
+		result.maxLatencyNs = qMax(result.maxLatencyNs, latency);
+		if (sequence > expectedSequence) {
+			result.missedFrames += sequence - expectedSequence;
+		}
+
+		expectedSequence = sequence + 1;
+	}
+
+	munmap(mapped, size);
+	close(shmFd);
+	close(eventFd);
+	close(socketFd);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication application(argc, argv);
+	const QStringList args = application.arguments();
+	const int width = args.size() > 1 ? args.at(1).toInt() : 640;
+	const int height = args.size() > 2 ? args.at(2).toInt() : 480;
+	const int seconds = args.size() > 3 ? args.at(3).toInt() : 5;
+	const int fps = args.size() > 4 ? args.at(4).toInt() : 0;
+
+	const int stride = width * 4;
+	SharedFramePublisher publisher;
+	if (!publisher.open(shmName, 4, stride * height)) {
+		fprintf(stderr, "%s\n", qPrintable(publisher.errorString()));
+		return 1;
+	}
+
+	std::atomic<bool> isRunning(true);
+	ReaderResult readerResult;
+	std::thread reader(readFrames, std::cref(isRunning), std::ref(readerResult));
+
+	// waiting for reader, publisher accepts it in event loop
+	QElapsedTimer timer;
+	timer.start();
+	while (publisher.readersCount() == 0 && timer.elapsed() < 2000) {
+		application.processEvents(QEventLoop::AllEvents, 10);
+	}
+
+	std::vector<uchar> frame(static_cast<size_t>(stride * height));
+	const qint64 periodNs = fps > 0 ? 1000000000LL / fps : 0;
+	timer.restart();
+	qint64 publishTimeNs = 0;
+	quint64 published = 0;
+	while (timer.elapsed() < seconds * 1000) {
+		memset(frame.data(), static_cast<int>(published & 0xff), 64);
+		QElapsedTimer publishTimer;
+		publishTimer.start();
+		publisher.publish(frame.data(), width, height, stride, rgb32);
+		publishTimeNs += publishTimer.nsecsElapsed();
+		++published;
+
+		if (published % 64 == 0) {
+			application.processEvents();
+		}
+
+		if (periodNs > 0) {
+			const qint64 sleepNs = static_cast<qint64>(published) * periodNs - timer.nsecsElapsed();
+			if (sleepNs > 0) {
+				QThread::usleep(static_cast<unsigned long>(sleepNs / 1000));
+			}
+		}
+	}
+
+	const double elapsed = timer.nsecsElapsed() / 1e9;
+	isRunning = false;
+	reader.join();
+
+	const double frameBytes = static_cast<double>(stride) * height;
+	printf("frame: %dx%d, %.1f MB\n", width, height, frameBytes / 1e6);
+	printf("published: %llu frames, %.1f fps, %.2f GB/s, %.1f us per frame\n"
+			, static_cast<unsigned long long>(published), published / elapsed
+			, published * frameBytes / elapsed / 1e9, publishTimeNs / 1e3 / qMax<quint64>(published, 1));
+	if (!readerResult.isConnected) {
+		printf("reader: couldn't connect\n");
+		return 1;
+	}
+
+	printf("read: %llu frames, %.1f fps, %.2f GB/s, missed %llu, torn %llu\n"
+			, static_cast<unsigned long long>(readerResult.frames), readerResult.frames / elapsed
+			, readerResult.bytes / elapsed / 1e9
+			, static_cast<unsigned long long>(readerResult.missedFrames)
+			, static_cast<unsigned long long>(readerResult.tornFrames));
+	printf("latency from publishing to reading: average %.1f us, max %.1f us\n"
+			, readerResult.totalLatencyNs / 1e3 / qMax<quint64>(readerResult.frames, 1)
+			, readerResult.maxLatencyNs / 1e3);
+	return 0;
+}
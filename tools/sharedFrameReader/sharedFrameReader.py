@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+# Copyright 2017 Konstantin Batoev.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Example of reading video frames that gamepad exports to shared memory (see sharedFrameFormat.h).
+# Export is turned on by "sharedMemory/enabled=true" in gamepad settings.
+# Frames are shown with OpenCV if it is installed, otherwise only their parameters are printed.
+# Needs Python 3.9 or newer for socket.recv_fds.
+#
+# Usage: sharedFrameReader.py [name], default name is /trik-gamepad-frames
+
+import mmap
+import os
+import socket
+import struct
+import sys
+
+import numpy
+
+if sys.version_info < (3, 9):
+    sys.exit("Python 3.9 or newer is needed to receive eventfd of gamepad")
+
+try:
+    import cv2
+except ImportError:
+    cv2 = None
+
+MAGIC = 0x464b5254
+RING_HEADER = struct.Struct("<IIIIIIQ32x")
+SLOT_HEADER = struct.Struct("<QQQIIIII20x")
+RGB32 = 1
+GRAYSCALE8 = 2
+
+
+def connect(name):
+    """Returns name of shared memory and eventfd received from gamepad."""
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+    sock.connect("\0" + name.lstrip("/"))
+    data, fds, _, _ = socket.recv_fds(sock, 256, 1)
+    # socket is kept open while we read, gamepad forgets about reader when it is closed
+    return sock, data.decode(), fds[0]
+
+
+def read_slot(memory, offset, sequence):
+    """Returns frame from slot as numpy array or None if the slot was overwritten while reading."""
+    lock, slot_sequence, timestamp, size, width, height, stride, fmt = SLOT_HEADER.unpack_from(memory, offset)
+    if lock % 2 or slot_sequence != sequence:
+        return None
+
+    start = offset + SLOT_HEADER.size
+    channels = 4 if fmt == RGB32 else 1
+    frame = numpy.frombuffer(memory, numpy.uint8, size, start).reshape(height, stride)
+    frame = frame[:, :width * channels].reshape(height, width, channels).copy()
+
+    # sequence lock: slot shall not change while we were copying it
+    if struct.unpack_from("<Q", memory, offset)[0] != lock:
+        return None
+    return frame, timestamp
+
+
+def main():
+    name = sys.argv[1] if len(sys.argv) > 1 else "/trik-gamepad-frames"
+    sock, shm_name, event_fd = connect(name)
+    fd = os.open("/dev/shm/" + shm_name.lstrip("/"), os.O_RDONLY)
+    memory = mmap.mmap(fd, 0, prot=mmap.PROT_READ)
+
+    magic, version, slot_count, slot_size, ring_header_size, slot_header_size, _ = RING_HEADER.unpack_from(memory, 0)
+    if magic != MAGIC or ring_header_size != RING_HEADER.size or slot_header_size != SLOT_HEADER.size:
+        sys.exit("Unsupported shared memory layout")
+
+    while True:
+        os.read(event_fd, 8)
+        next_sequence = struct.unpack_from("<Q", memory, 24)[0]
+        if next_sequence == 0:
+            continue
+
+        sequence = next_sequence - 1
+        offset = RING_HEADER.size + (sequence % slot_count) * (SLOT_HEADER.size + slot_size)
+        result = read_slot(memory, offset, sequence)
+        if result is None:
+            continue
+
+        frame, timestamp = result
+        if cv2 is not None:
+            cv2.imshow("TRIK camera", frame)
+            if cv2.waitKey(1) == 27:
+                break
+        else:
+            print("frame", sequence, frame.shape, timestamp)
+
+    sock.close()
+
+
+if __name__ == "__main__":
+    main()
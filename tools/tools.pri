@@ -0,0 +1,32 @@
+# Copyright 2017 Konstantin Batoev.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Settings shared by all tools, they use the same warnings as gamepad itself.
+
+QMAKE_CXXFLAGS += -Wall -Wextra -Wpedantic -Wold-style-cast -Wconversion
+QMAKE_CXXFLAGS += -Winit-self -Wunreachable-code
+QMAKE_CXXFLAGS += -Werror -Wno-conversion
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+# sources of gamepad are shared with tools
+GAMEPAD_DIR = $$PWD/..
+INCLUDEPATH += $$GAMEPAD_DIR
+
+# code shared by tools
+COMMON_DIR = $$PWD/common
+INCLUDEPATH += $$COMMON_DIR
@@ -0,0 +1,244 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "tracer.h"
+
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace {
+/// events of one thread, the oldest ones are overwritten
+const quint64 eventsPerThread = 64 * 1024;
+
+struct TraceEvent
+{
+	const char *name;
+	qint64 timestampNs;
+	qint64 durationNs;
+	quint64 value;
+	char phase;
+};
+
+struct ThreadTrace
+{
+	explicit ThreadTrace(int id)
+		: events(eventsPerThread)
+		, count(0)
+		, threadId(id)
+		, isFinished(false)
+	{
+	}
+
+	std::vector<TraceEvent> events;
+	std::atomic<quint64> count;
+
+	/// fields below are guarded by threadsMutex
+	int threadId;
+	QByteArray name;
+	bool isFinished;
+};
+
+/// buffers of finished threads are kept, so their events can be dumped too, until a new thread takes the buffer.
+/// So thread pools that recreate their threads do not add a buffer for every new thread
+QMutex threadsMutex;
+QVector<ThreadTrace *> threads;
+int lastThreadId = 0;
+
+/// gives buffer back when its thread finishes
+struct ThreadTraceOwner
+{
+	~ThreadTraceOwner()
+	{
+		if (trace) {
+			QMutexLocker locker(&threadsMutex);
+			trace->isFinished = true;
+		}
+	}
+
+	ThreadTrace *trace = nullptr;
+};
+
+thread_local ThreadTraceOwner currentThread;
+
+ThreadTrace *threadTrace()
+{
+	if (!currentThread.trace) {
+		QMutexLocker locker(&threadsMutex);
+		// threads are in order of creation, so the buffer of the earliest finished thread is taken
+		const auto finished = std::find_if(threads.begin(), threads.end(), [](const ThreadTrace *trace) {
+			return trace->isFinished;
+		});
+		ThreadTrace *trace = nullptr;
+		if (finished != threads.end()) {
+			trace = *finished;
+			threads.erase(finished);
+			trace->count.store(0, std::memory_order_relaxed);
+			trace->threadId = ++lastThreadId;
+			trace->isFinished = false;
+		} else {
+			trace = new ThreadTrace(++lastThreadId);
+		}
+
+		const QThread *thread = QThread::currentThread();
+		trace->name = thread && !thread->objectName().isEmpty()
+				? thread->objectName().toUtf8() : "thread " + QByteArray::number(trace->threadId);
+		threads.append(trace);
+		currentThread.trace = trace;
+	}
+
+	return currentThread.trace;
+}
+
+void record(const char *name, char phase, qint64 timestampNs, qint64 durationNs, quint64 value)
+{
+	ThreadTrace *trace = threadTrace();
+	const quint64 index = trace->count.load(std::memory_order_relaxed);
+	trace->events[index % eventsPerThread] = {name, timestampNs, durationNs, value, phase};
+	trace->count.store(index + 1, std::memory_order_release);
+}
+
+QByteArray microseconds(qint64 ns)
+{
+	return QByteArray::number(ns / 1000.0, 'f', 3);
+}
+
+/// JSON string with quotes, names of threads come from QThread object names and may contain anything
+QByteArray jsonString(const QByteArray &text)
+{
+	QByteArray result = "\"";
+	for (const char c : text) {
+		if (c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		} else if (static_cast<uchar>(c) < 0x20) {
+			result += "\\u00" + QByteArray::number(static_cast<uchar>(c), 16).rightJustified(2, '0');
+		} else {
+			result += c;
+		}
+	}
+
+	return result + '"';
+}
+}
+
+std::atomic<bool> Tracer::isTracing(false);
+std::atomic<quint64> Tracer::commandIds(0);
+
+void Tracer::setEnabled(bool isEnabled)
+{
+	isTracing = isEnabled;
+}
+
+qint64 Tracer::timestamp()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::complete(const char *name, qint64 startNs, qint64 durationNs, quint64 argument)
+{
+	if (isEnabled()) {
+		record(name, 'X', startNs, durationNs, argument);
+	}
+}
+
+void Tracer::asyncBegin(const char *name, quint64 id)
+{
+	if (isEnabled()) {
+		record(name, 'b', timestamp(), 0, id);
+	}
+}
+
+void Tracer::asyncEnd(const char *name, quint64 id)
+{
+	if (isEnabled()) {
+		record(name, 'e', timestamp(), 0, id);
+	}
+}
+
+void Tracer::setThreadName(const char *name)
+{
+	if (isEnabled()) {
+		ThreadTrace *trace = threadTrace();
+		QMutexLocker locker(&threadsMutex);
+		trace->name = name;
+	}
+}
+
+quint64 Tracer::nextCommandId()
+{
+	return ++commandIds;
+}
+
+bool Tracer::dump(const QString &fileName, QString &errorString)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		errorString = file.errorString();
+		return false;
+	}
+
+	// buffers are not taken by new threads while they are dumped, recording itself is not blocked
+	QMutexLocker locker(&threadsMutex);
+	QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool isFirst = true;
+	for (ThreadTrace *trace : threads) {
+		const QByteArray tid = QByteArray::number(trace->threadId);
+		json += QByteArray(isFirst ? "" : ",\n") + "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid
+				+ ",\"args\":{\"name\":" + jsonString(trace->name) + "}}";
+		isFirst = false;
+
+		// events are copied first, then the ones that could be overwritten while copying are dropped
+		const quint64 count = trace->count.load(std::memory_order_acquire);
+		const quint64 first = count > eventsPerThread ? count - eventsPerThread : 0;
+		std::vector<TraceEvent> events;
+		events.reserve(static_cast<size_t>(count - first));
+		for (quint64 i = first; i < count; ++i) {
+			events.push_back(trace->events[i % eventsPerThread]);
+		}
+
+		const quint64 countAfterCopy = trace->count.load(std::memory_order_acquire);
+		const quint64 firstIntact = countAfterCopy >= eventsPerThread ? countAfterCopy - eventsPerThread + 1 : 0;
+		for (quint64 i = std::max(first, firstIntact); i < count; ++i) {
+			const TraceEvent &event = events[static_cast<size_t>(i - first)];
+			json += ",\n{\"name\":" + jsonString(event.name) + ",\"cat\":\"gamepad\",\"ph\":\"" + event.phase
+					+ "\",\"pid\":1,\"tid\":" + tid + ",\"ts\":" + microseconds(event.timestampNs);
+			if (event.phase == 'X') {
+				json += ",\"dur\":" + microseconds(event.durationNs) + ",\"args\":{\"value\":"
+						+ QByteArray::number(event.value) + "}}";
+			} else {
+				json += ",\"id\":" + QByteArray::number(event.value) + "}";
+			}
+		}
+	}
+
+	json += "\n]}\n";
+	locker.unlock();
+	if (file.write(json) != json.size()) {
+		errorString = file.errorString();
+		return false;
+	}
+
+	return true;
+}
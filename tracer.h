@@ -0,0 +1,86 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QString>
+
+#include <atomic>
+
+/// Records timeline of input -> network -> video pipeline in a way that can be opened by chrome://tracing
+/// or Perfetto. Every thread writes to its own ring buffer without locks, so tracing is cheap enough to be
+/// turned on while driving; when it is off every call only checks a flag. Is turned on by --trace option.
+class Tracer
+{
+public:
+	static void setEnabled(bool isEnabled);
+
+	static bool isEnabled()
+	{
+		return isTracing.load(std::memory_order_relaxed);
+	}
+
+	/// steady clock in nanoseconds
+	static qint64 timestamp();
+
+	/// name should be a string literal, it is stored as a pointer. Argument is shown as "value" of the span
+	static void complete(const char *name, qint64 startNs, qint64 durationNs, quint64 argument = 0);
+
+	/// span that begins in one thread and ends in another one, like a command queued to connection thread
+	static void asyncBegin(const char *name, quint64 id);
+	static void asyncEnd(const char *name, quint64 id);
+
+	/// name of current thread in trace, thread without name is shown by its QThread object name
+	static void setThreadName(const char *name);
+
+	/// id of "queued hop" span of a command, it travels with the command to connection thread
+	static quint64 nextCommandId();
+
+	/// writes everything that is in ring buffers as Chrome trace event JSON
+	static bool dump(const QString &fileName, QString &errorString);
+
+private:
+	static std::atomic<bool> isTracing;
+	static std::atomic<quint64> commandIds;
+};
+
+/// Records a span from construction to destruction of the object.
+class TraceSpan
+{
+public:
+	explicit TraceSpan(const char *name, quint64 argument = 0)
+		: mName(name)
+		, mArgument(argument)
+		, mStartNs(Tracer::isEnabled() ? Tracer::timestamp() : -1)
+	{
+	}
+
+	~TraceSpan()
+	{
+		if (mStartNs >= 0) {
+			Tracer::complete(mName, mStartNs, Tracer::timestamp() - mStartNs, mArgument);
+		}
+	}
+
+private:
+	TraceSpan(const TraceSpan &other);
+	TraceSpan & operator=(const TraceSpan &other);
+
+	const char *mName;
+	quint64 mArgument;
+	qint64 mStartNs;
+};
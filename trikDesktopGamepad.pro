@@ -24,7 +24,7 @@ QMAKE_CXXFLAGS += -Werror -Wno-conversion
 # QMAKE_CXXFLAGS += -isystem "$(QTDIR)/include"
 # QMAKE_CXXFLAGS += -isystem "$(QTDIR)/include/QtMultimediaWidgets"
 
-QT += core gui network widgets multimedia multimediawidgets
+QT += core gui network widgets
 
 CONFIG += c++11
 
@@ -37,13 +37,58 @@ SOURCES += main.cpp \
         connectionManager.cpp \
         standardStrategy.cpp \
         accelerateStrategy.cpp \
-        strategy.cpp
+        strategy.cpp \
+        mjpegStreamReader.cpp \
+        videoDecoder.cpp \
+        frameView.cpp \
+        frameRingBuffer.cpp \
+        snapshotExporter.cpp \
+        videoWatchdog.cpp \
+        sharedFramePublisher.cpp \
+        inputDispatcher.cpp \
+        startupProfiler.cpp \
+        headlessController.cpp \
+        tracer.cpp \
+        commandJournal.cpp \
+        commandProtocol.cpp \
+        metrics.cpp \
+        metricsServer.cpp \
+        commandScheduler.cpp \
+        deadManWatchdog.cpp \
+        gamepadState.cpp \
+        robotScanner.cpp \
+        preConnector.cpp \
+        telemetryReader.cpp \
+        plotSeries.cpp \
+        plotPanel.cpp \
+        automationServer.cpp
 
 TRANSLATIONS += languages/trikDesktopGamepad_ru.ts \
                 languages/trikDesktopGamepad_en.ts \
                 languages/trikDesktopGamepad_fr.ts \
                 languages/trikDesktopGamepad_de.ts
 
+# .qm catalogs are compiled from TRANSLATIONS at build time by lrelease feature, it appeared in Qt 5.12
+equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 12) {
+	error("Qt 5.12 or newer is needed to compile translations")
+}
+
+CONFIG += lrelease
+LRELEASE_DIR = .qm
+
+# catalogs are put into resources as :/languages/*.qm by resource file written here instead of embed_translations,
+# so they alone are stored uncompressed (compression never saves 100%) and QTranslator uses them in place
+LANGUAGES_QRC = $$OUT_PWD/languages.qrc
+languages_qrc_content = "<!DOCTYPE RCC><RCC version=\"1.0\">" "<qresource prefix=\"/languages\">"
+for (translation, TRANSLATIONS) {
+	qm_file = $$basename(translation)
+	qm_file = $$replace(qm_file, \\.ts$, .qm)
+	languages_qrc_content += "<file alias=\"$$qm_file\" threshold=\"100\">$$OUT_PWD/$$LRELEASE_DIR/$$qm_file</file>"
+}
+languages_qrc_content += "</qresource>" "</RCC>"
+!write_file($$LANGUAGES_QRC, languages_qrc_content): error("Can not write $$LANGUAGES_QRC")
+RESOURCES += $$LANGUAGES_QRC
+
 target.path =
 HEADERS += \
         gamepadForm.h \
@@ -51,7 +96,34 @@ HEADERS += \
         connectionManager.h \
         standardStrategy.h \
         accelerateStrategy.h \
-        strategy.h
+        strategy.h \
+        mjpegStreamReader.h \
+        videoDecoder.h \
+        frameView.h \
+        frameRingBuffer.h \
+        snapshotExporter.h \
+        videoMetrics.h \
+        videoWatchdog.h \
+        sharedFrameFormat.h \
+        sharedFramePublisher.h \
+        inputDispatcher.h \
+        startupProfiler.h \
+        headlessController.h \
+        tracer.h \
+        commandJournalFormat.h \
+        commandJournal.h \
+        commandProtocol.h \
+        metrics.h \
+        metricsServer.h \
+        commandScheduler.h \
+        deadManWatchdog.h \
+        gamepadState.h \
+        robotScanner.h \
+        preConnector.h \
+        telemetryReader.h \
+        plotSeries.h \
+        plotPanel.h \
+        automationServer.h
 
 FORMS += \
         gamepadForm.ui \
@@ -61,3 +133,5 @@ RESOURCES += \
         images.qrc \
         fonts.qrc
 
+# shared memory export of video frames
+linux: LIBS += -lrt
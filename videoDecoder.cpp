@@ -0,0 +1,243 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "videoDecoder.h"
+
+#include <QRunnable>
+#include <QBuffer>
+#include <QImageReader>
+
+#include "tracer.h"
+
+namespace {
+
+/// decodes one frame in pool thread and passes result back to decoder
+class DecodeTask : public QRunnable
+{
+public:
+	DecodeTask(QObject *decoder, const QByteArray &jpeg, quint64 sequence, const QSize &targetSize)
+		: mDecoder(decoder)
+		, mJpeg(jpeg)
+		, mSequence(sequence)
+		, mTargetSize(targetSize)
+	{
+	}
+
+	void run() override
+	{
+		TraceSpan span("decode", mSequence);
+		QElapsedTimer timer;
+		timer.start();
+
+		QBuffer buffer(&mJpeg);
+		buffer.open(QIODevice::ReadOnly);
+		QImageReader reader(&buffer, "JPG");
+		const int denominator = scaleDenominator(reader.size());
+		if (denominator > 1) {
+			// JPEG plugin passes scaled size to libjpeg, so downscaling is done while decoding
+			const QSize size = reader.size();
+			reader.setScaledSize(QSize((size.width() + denominator - 1) / denominator
+					, (size.height() + denominator - 1) / denominator));
+		}
+
+		const QImage image = reader.read();
+		const qint64 decodeTimeNs = timer.nsecsElapsed();
+
+		QMetaObject::invokeMethod(mDecoder, "handleDecoded", Qt::QueuedConnection
+				, Q_ARG(QImage, image), Q_ARG(quint64, mSequence), Q_ARG(qint64, decodeTimeNs)
+				, Q_ARG(int, denominator));
+	}
+
+private:
+	/// the greatest of 8, 4 and 2 that keeps decoded frame not less than target size, or 1
+	int scaleDenominator(const QSize &frameSize) const
+	{
+		if (mTargetSize.isEmpty() || !frameSize.isValid()) {
+			return 1;
+		}
+
+		for (int denominator = 8; denominator > 1; denominator /= 2) {
+			if (frameSize.width() / denominator >= mTargetSize.width()
+					&& frameSize.height() / denominator >= mTargetSize.height()) {
+				return denominator;
+			}
+		}
+
+		return 1;
+	}
+
+	QObject *mDecoder;
+	QByteArray mJpeg;
+	quint64 mSequence;
+	QSize mTargetSize;
+};
+
+/// how many frames are allowed to wait for decoding in ordered mode for each thread
+const int waitingJobsPerThread = 4;
+
+}
+
+VideoDecoder::VideoDecoder(QObject *parent)
+	: QObject(parent)
+	, mIsLatestOnly(true)
+	, mHasPresented(false)
+	, mLastPresented(0)
+	, mReceivedFrames(0)
+	, mPresentedFrames(0)
+	, mDecodedFramesCount(0)
+	, mDecodeTimeNs(0)
+	, mDroppedFrames(0)
+	, mScaleDenominator(1)
+{
+	mMetricsTimer.start();
+}
+
+VideoDecoder::~VideoDecoder()
+{
+	// tasks post their results to this object, so they shall not outlive it
+	mPool.waitForDone();
+}
+
+void VideoDecoder::setThreadCount(int threadCount)
+{
+	mPool.setMaxThreadCount(qMax(1, threadCount));
+}
+
+void VideoDecoder::setLatestOnly(bool isLatestOnly)
+{
+	mIsLatestOnly = isLatestOnly;
+}
+
+void VideoDecoder::setTargetSize(const QSize &size)
+{
+	mTargetSize = size;
+}
+
+void VideoDecoder::submit(const QByteArray &jpeg, quint64 sequence)
+{
+	++mReceivedFrames;
+
+	const Job job = {jpeg, sequence};
+	const int threadCount = mPool.maxThreadCount();
+	if (static_cast<int>(mDecodingSequences.size()) < threadCount) {
+		startJob(job);
+		return;
+	}
+
+	// all threads are busy, frame waits; the oldest waiting frames are superseded if there are too many of them
+	const int maxWaitingJobs = mIsLatestOnly ? 1 : waitingJobsPerThread * threadCount;
+	mWaitingJobs.enqueue(job);
+	while (mWaitingJobs.size() > maxWaitingJobs) {
+		mWaitingJobs.dequeue();
+		++mDroppedFrames;
+	}
+}
+
+void VideoDecoder::reset()
+{
+	mDroppedFrames += static_cast<quint64>(mWaitingJobs.size() + mDecodedFrames.size());
+	mWaitingJobs.clear();
+	mDecodedFrames.clear();
+
+	// frames that are being decoded now will be ignored when they are ready
+	if (!mDecodingSequences.empty()) {
+		mHasPresented = true;
+		mLastPresented = *mDecodingSequences.rbegin();
+	}
+}
+
+VideoMetrics VideoDecoder::takeMetrics()
+{
+	const double seconds = qMax<qint64>(1, mMetricsTimer.restart()) / 1000.0;
+
+	VideoMetrics metrics;
+	metrics.receivedFps = mReceivedFrames / seconds;
+	metrics.presentedFps = mPresentedFrames / seconds;
+	metrics.decodedFps = mDecodedFramesCount / seconds;
+	metrics.averageDecodeMs = mDecodedFramesCount > 0 ? mDecodeTimeNs / 1e6 / mDecodedFramesCount : 0;
+	metrics.droppedFrames = mDroppedFrames;
+	metrics.decodeThreads = mPool.maxThreadCount();
+	metrics.decodeScaleDenominator = mScaleDenominator;
+
+	mReceivedFrames = 0;
+	mPresentedFrames = 0;
+	mDecodedFramesCount = 0;
+	mDecodeTimeNs = 0;
+	return metrics;
+}
+
+void VideoDecoder::handleDecoded(const QImage &image, quint64 sequence, qint64 decodeTimeNs, int scaleDenominator)
+{
+	mDecodingSequences.erase(sequence);
+	++mDecodedFramesCount;
+	mDecodeTimeNs += decodeTimeNs;
+	mScaleDenominator = scaleDenominator;
+
+	if (mHasPresented && sequence <= mLastPresented) {
+		// frame was superseded while it was being decoded
+		++mDroppedFrames;
+	} else if (image.isNull()) {
+		++mDroppedFrames;
+	} else {
+		mDecodedFrames.insert(sequence, image);
+	}
+
+	presentReadyFrames();
+
+	while (!mWaitingJobs.isEmpty() && static_cast<int>(mDecodingSequences.size()) < mPool.maxThreadCount()) {
+		startJob(mWaitingJobs.dequeue());
+	}
+}
+
+void VideoDecoder::startJob(const Job &job)
+{
+	mDecodingSequences.insert(job.sequence);
+	mPool.start(new DecodeTask(this, job.jpeg, job.sequence, mTargetSize));
+}
+
+void VideoDecoder::presentReadyFrames()
+{
+	if (mDecodedFrames.isEmpty()) {
+		return;
+	}
+
+	if (mIsLatestOnly) {
+		// showing the newest decoded frame right away, older frames including those still in decoding are skipped
+		const quint64 sequence = mDecodedFrames.lastKey();
+		const QImage image = mDecodedFrames.last();
+		mDroppedFrames += static_cast<quint64>(mDecodedFrames.size() - 1);
+		mDecodedFrames.clear();
+
+		mHasPresented = true;
+		mLastPresented = sequence;
+		++mPresentedFrames;
+		emit frameDecoded(image, sequence);
+		return;
+	}
+
+	// reorder stage: frame is shown only when all earlier frames are decoded
+	while (!mDecodedFrames.isEmpty()
+			&& (mDecodingSequences.empty() || mDecodedFrames.firstKey() < *mDecodingSequences.begin())) {
+		const quint64 sequence = mDecodedFrames.firstKey();
+		const QImage image = mDecodedFrames.take(sequence);
+
+		mHasPresented = true;
+		mLastPresented = sequence;
+		++mPresentedFrames;
+		emit frameDecoded(image, sequence);
+	}
+}
@@ -0,0 +1,103 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QImage>
+#include <QQueue>
+#include <QMap>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+#include <set>
+
+#include "videoMetrics.h"
+
+/// Decodes JPEG frames of video stream on a pool of threads. Decoded frames are reordered, so they are
+/// shown in the order they were received. With latest-only policy frames that are already superseded by
+/// newer decoded frame are skipped instead of being waited for.
+/// Object itself lives in GUI thread, only decoding is done in the pool.
+class VideoDecoder : public QObject
+{
+	Q_OBJECT
+
+private:
+	VideoDecoder(const VideoDecoder &other);
+	VideoDecoder & operator=(const VideoDecoder &other);
+
+public:
+	explicit VideoDecoder(QObject *parent = nullptr);
+	~VideoDecoder() override;
+
+	void setThreadCount(int threadCount);
+	void setLatestOnly(bool isLatestOnly);
+
+	/// sets size of widget that shows frames; if frames are much bigger, they are decoded with resolution
+	/// reduced by 2, 4 or 8 times right in DCT domain. Empty size turns reduction off.
+	void setTargetSize(const QSize &size);
+
+	/// passes frame for decoding, frame with greater sequence number shall be passed later
+	void submit(const QByteArray &jpeg, quint64 sequence);
+
+	/// forgets about frames that were not shown yet
+	void reset();
+
+	/// returns statistics since previous call
+	VideoMetrics takeMetrics();
+
+signals:
+	void frameDecoded(const QImage &image, quint64 sequence);
+
+private slots:
+	void handleDecoded(const QImage &image, quint64 sequence, qint64 decodeTimeNs, int scaleDenominator);
+
+private:
+	struct Job
+	{
+		QByteArray jpeg;
+		quint64 sequence;
+	};
+
+	void startJob(const Job &job);
+	void presentReadyFrames();
+
+	QThreadPool mPool;
+	bool mIsLatestOnly;
+	QSize mTargetSize;
+
+	/// frames waiting for free decoding thread
+	QQueue<Job> mWaitingJobs;
+
+	/// frames that are being decoded now
+	std::set<quint64> mDecodingSequences;
+
+	/// decoded frames that wait for previous frames
+	QMap<quint64, QImage> mDecodedFrames;
+
+	bool mHasPresented;
+	quint64 mLastPresented;
+
+	/// counters for metrics
+	QElapsedTimer mMetricsTimer;
+	int mReceivedFrames;
+	int mPresentedFrames;
+	int mDecodedFramesCount;
+	qint64 mDecodeTimeNs;
+	quint64 mDroppedFrames;
+	int mScaleDenominator;
+};
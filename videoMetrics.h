@@ -0,0 +1,52 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QtGlobal>
+
+/// Statistics of video path for the last measurement period.
+struct VideoMetrics
+{
+	/// frames per second received from camera
+	double receivedFps = 0;
+
+	/// frames per second shown to user
+	double presentedFps = 0;
+
+	/// frames per second decoded by all decoding threads together
+	double decodedFps = 0;
+
+	/// average time of decoding one frame in one thread
+	double averageDecodeMs = 0;
+
+	/// frames that were received but not shown, total for the stream
+	quint64 droppedFrames = 0;
+
+	int decodeThreads = 0;
+
+	/// frames are decoded with resolution divided by this number
+	int decodeScaleDenominator = 1;
+
+	/// number of times stream was reconnected after stall and duration of the last reconnect
+	int reconnects = 0;
+	qint64 lastReconnectMs = 0;
+
+	/// interval between snapshot requests and their smoothed download time, 0 if stream is not polled
+	int snapshotIntervalMs = 0;
+	double snapshotDownloadMs = 0;
+};
@@ -0,0 +1,113 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#include "videoWatchdog.h"
+
+namespace {
+const int checkPeriodMs = 200;
+}
+
+VideoWatchdog::VideoWatchdog(QObject *parent)
+	: QObject(parent)
+	, mIsArmed(false)
+	, mIsStalled(false)
+	, mStallTimeoutMs(3000)
+	, mMaxBackoffMs(30 * 1000)
+	, mBackoffMs(mStallTimeoutMs)
+	, mReconnects(0)
+	, mLastReconnectTimeMs(0)
+{
+	connect(&mTimer, SIGNAL(timeout()), this, SLOT(check()));
+}
+
+void VideoWatchdog::setStallTimeout(int stallTimeoutMs)
+{
+	mStallTimeoutMs = stallTimeoutMs;
+}
+
+void VideoWatchdog::setMaxBackoff(int maxBackoffMs)
+{
+	mMaxBackoffMs = maxBackoffMs;
+}
+
+void VideoWatchdog::arm()
+{
+	mIsArmed = true;
+	mIsStalled = false;
+	mSinceLastFrame.start();
+	mTimer.start(checkPeriodMs);
+}
+
+void VideoWatchdog::frameArrived()
+{
+	mSinceLastFrame.start();
+	if (mIsStalled) {
+		mIsStalled = false;
+		++mReconnects;
+		mLastReconnectTimeMs = mSinceStall.elapsed();
+	}
+}
+
+void VideoWatchdog::streamLost()
+{
+	if (mIsArmed && !mIsStalled) {
+		// stream is already closed, so there is no need to wait for timeout, but first attempt is delayed
+		// to avoid reconnecting in a loop to camera that refuses connections
+		startStall();
+		mSinceAttempt.start();
+	}
+}
+
+int VideoWatchdog::reconnects() const
+{
+	return mReconnects;
+}
+
+qint64 VideoWatchdog::lastReconnectTimeMs() const
+{
+	return mLastReconnectTimeMs;
+}
+
+void VideoWatchdog::check()
+{
+	if (!mIsArmed) {
+		return;
+	}
+
+	if (!mIsStalled) {
+		if (mSinceLastFrame.elapsed() > mStallTimeoutMs) {
+			startStall();
+			requestReconnect();
+		}
+	} else if (mSinceAttempt.elapsed() >= mBackoffMs) {
+		mBackoffMs = qMin(2 * mBackoffMs, mMaxBackoffMs);
+		requestReconnect();
+	}
+}
+
+void VideoWatchdog::startStall()
+{
+	mIsStalled = true;
+	mSinceStall.start();
+	mBackoffMs = mStallTimeoutMs;
+}
+
+void VideoWatchdog::requestReconnect()
+{
+	mSinceAttempt.start();
+	emit reconnectRequested();
+}
@@ -0,0 +1,80 @@
+/* Copyright 2017 Konstantin Batoev.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file was modified by Konstantin Batoev to make it comply with the requirements of trikRuntime
+ * project. See git revision history for detailed changes. */
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+/// Watches that camera stream keeps delivering frames. If there were no frames for a period of time
+/// (or the stream was lost), it asks to reconnect the stream, repeating with growing intervals until frames come again.
+class VideoWatchdog : public QObject
+{
+	Q_OBJECT
+
+private:
+	VideoWatchdog(const VideoWatchdog &other);
+	VideoWatchdog & operator=(const VideoWatchdog &other);
+
+public:
+	explicit VideoWatchdog(QObject *parent = nullptr);
+
+	/// stream is considered stalled if there were no frames for so many milliseconds
+	void setStallTimeout(int stallTimeoutMs);
+
+	/// reconnecting attempts are repeated after this interval, it doubles after every attempt up to given maximum
+	void setMaxBackoff(int maxBackoffMs);
+
+	/// starts watching for stream that was just opened; gamepad never closes the stream on its own, so watching
+	/// goes on until the next stream is opened
+	void arm();
+
+	void frameArrived();
+
+	/// is called when stream was closed or failed
+	void streamLost();
+
+	int reconnects() const;
+
+	/// time from the moment stall was detected to the first frame after reconnect
+	qint64 lastReconnectTimeMs() const;
+
+signals:
+	void reconnectRequested();
+
+private slots:
+	void check();
+
+private:
+	void startStall();
+	void requestReconnect();
+
+	QTimer mTimer;
+	QElapsedTimer mSinceLastFrame;
+	QElapsedTimer mSinceStall;
+	QElapsedTimer mSinceAttempt;
+
+	bool mIsArmed;
+	bool mIsStalled;
+	int mStallTimeoutMs;
+	int mMaxBackoffMs;
+	int mBackoffMs;
+
+	int mReconnects;
+	qint64 mLastReconnectTimeMs;
+};